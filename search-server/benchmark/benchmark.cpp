@@ -0,0 +1,312 @@
+// Бенчмарк основных операций SearchServer на синтетическом корпусе.
+// Сборка из каталога search-server, см. README.md:
+//   g++ -std=c++17 -O2 -DNDEBUG -Iinclude -Ibenchmark src/*.cpp benchmark/*.cpp -o search_server_benchmark -ltbb -lpthread
+// С -DSEARCH_SERVER_METRICS в JSON попадают и внутренние замеры сервера по фазам
+// Результат — JSON в stdout или в файл --output
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <execution>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "corpus_generator.h"
+#include "metrics.h"
+#include "process_queries.h"
+#include "search_server.h"
+#include "thread_pool.h"
+
+namespace {
+
+struct BenchmarkOptions {
+    std::vector<size_t> corpus_sizes = { 1000, 10000, 100000 };
+    std::vector<size_t> thread_counts = { 1, std::max<size_t>(1, std::thread::hardware_concurrency()) };
+    size_t query_count = 1000;
+    // Сколько раз прогоняется пакет ProcessQueries
+    size_t batch_repeat_count = 5;
+    // Доля документов, удаляемых в каждом из режимов удаления
+    double remove_share = 0.05;
+    uint64_t seed = 42;
+    std::string output_path;
+};
+
+struct LatencySummary {
+    double mean_ns = 0.0;
+    uint64_t p50_ns = 0;
+    uint64_t p90_ns = 0;
+    uint64_t p99_ns = 0;
+    uint64_t max_ns = 0;
+};
+
+struct OperationResult {
+    std::string operation;
+    size_t document_count;
+    size_t thread_count;
+    size_t operation_count;
+    size_t item_count; // запросов или документов: пакет — одна операция из многих элементов
+    double seconds;
+    LatencySummary latency;
+    long peak_rss_kb;
+};
+
+using Clock = std::chrono::steady_clock;
+
+// Пиковый размер резидентной памяти процесса с момента запуска
+long GetPeakRssKb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss; // в Linux — в килобайтах
+}
+
+LatencySummary Summarize(std::vector<uint64_t>& latencies) {
+    LatencySummary summary;
+    if (latencies.empty()) {
+        return summary;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    const auto percentile = [&latencies](double share) {
+        return latencies[std::min(latencies.size() - 1, static_cast<size_t>(share * latencies.size()))];
+    };
+    double total = 0.0;
+    for (const uint64_t latency : latencies) {
+        total += static_cast<double>(latency);
+    }
+    summary.mean_ns = total / latencies.size();
+    summary.p50_ns = percentile(0.5);
+    summary.p90_ns = percentile(0.9);
+    summary.p99_ns = percentile(0.99);
+    summary.max_ns = latencies.back();
+    return summary;
+}
+
+// Вызывает operation(i) для i из [0, count), замеряя каждый вызов
+template <typename Operation>
+OperationResult Measure(std::string name, size_t document_count, size_t thread_count,
+                        size_t count, size_t items_per_operation, Operation operation) {
+    std::vector<uint64_t> latencies;
+    latencies.reserve(count);
+    const auto start = Clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        const auto operation_start = Clock::now();
+        operation(i);
+        latencies.push_back(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now() - operation_start).count()));
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return { std::move(name), document_count, thread_count, count, count * items_per_operation,
+             seconds, Summarize(latencies), GetPeakRssKb() };
+}
+
+// Перестановка Фишера — Йетса на генераторе бенчмарка, чтобы не зависеть от std::shuffle
+std::vector<int> ShuffledIds(size_t count, uint64_t seed) {
+    std::vector<int> ids(count);
+    for (size_t i = 0; i < count; ++i) {
+        ids[i] = static_cast<int>(i);
+    }
+    BenchmarkRandom random(seed);
+    for (size_t i = count; i > 1; --i) {
+        std::swap(ids[i - 1], ids[static_cast<size_t>(random.NextInt(0, static_cast<int64_t>(i) - 1))]);
+    }
+    return ids;
+}
+
+// Удерживает результат от удаления оптимизатором
+volatile size_t result_sink = 0;
+
+void RunCorpusBenchmarks(const BenchmarkOptions& options, const SyntheticCorpus& corpus,
+                         const std::vector<std::string>& queries, size_t thread_count,
+                         std::vector<OperationResult>& results) {
+    const size_t document_count = corpus.documents.size();
+    ThreadPool pool(thread_count - 1); // вызывающий поток работает вместе с пулом
+    SearchServer server(corpus.stop_words);
+    server.SetThreadPool(pool);
+    // Запросы генератора содержат обязательные слова
+    server.SetQuerySyntax(QuerySyntax::REQUIRED_TERMS);
+
+    results.push_back(Measure("AddDocument", document_count, thread_count, document_count, 1, [&](size_t i) {
+        const SyntheticDocument& document = corpus.documents[i];
+        server.AddDocument(document.id, document.text, document.status, document.ratings);
+    }));
+    {
+        std::vector<NewDocument> documents;
+        documents.reserve(document_count);
+        for (const SyntheticDocument& document : corpus.documents) {
+            documents.push_back({ document.id, document.text, document.status, document.ratings });
+        }
+        SearchServer bulk_server(corpus.stop_words);
+        bulk_server.SetThreadPool(pool);
+        results.push_back(Measure("AddDocuments", document_count, thread_count, 1, document_count, [&](size_t) {
+            bulk_server.AddDocuments(documents);
+        }));
+    }
+
+    // Прогрев: кеши процессора и IDF терминов запросов
+    for (const std::string& query : queries) {
+        result_sink += server.FindTopDocuments(query).size();
+    }
+    results.push_back(Measure("FindTopDocuments/seq", document_count, thread_count, queries.size(), 1, [&](size_t i) {
+        result_sink += server.FindTopDocuments(std::execution::seq, queries[i]).size();
+    }));
+    results.push_back(Measure("FindTopDocuments/par", document_count, thread_count, queries.size(), 1, [&](size_t i) {
+        result_sink += server.FindTopDocuments(std::execution::par, queries[i]).size();
+    }));
+
+    results.push_back(Measure("MatchDocument/seq", document_count, thread_count, queries.size(), 1, [&](size_t i) {
+        const int document_id = static_cast<int>(i * 7919 % document_count);
+        result_sink += std::get<0>(server.MatchDocument(std::execution::seq, queries[i], document_id)).size();
+    }));
+    results.push_back(Measure("MatchDocument/par", document_count, thread_count, queries.size(), 1, [&](size_t i) {
+        const int document_id = static_cast<int>(i * 7919 % document_count);
+        result_sink += std::get<0>(server.MatchDocument(std::execution::par, queries[i], document_id)).size();
+    }));
+
+    results.push_back(Measure("ProcessQueries", document_count, thread_count, options.batch_repeat_count, queries.size(), [&](size_t) {
+        result_sink += ProcessQueries(server, queries).size();
+    }));
+    results.push_back(Measure("ProcessQueriesJoined", document_count, thread_count, options.batch_repeat_count, queries.size(), [&](size_t) {
+        result_sink += ProcessQueriesJoined(server, queries).size();
+    }));
+
+    // Удаление в конце: оно меняет индекс. Режимы удаляют разные документы
+    const size_t remove_count = static_cast<size_t>(document_count * options.remove_share);
+    const std::vector<int> ids = ShuffledIds(document_count, options.seed);
+    results.push_back(Measure("RemoveDocument/seq", document_count, thread_count, remove_count, 1, [&](size_t i) {
+        server.RemoveDocument(std::execution::seq, ids[i]);
+    }));
+    results.push_back(Measure("RemoveDocument/par", document_count, thread_count, remove_count, 1, [&](size_t i) {
+        server.RemoveDocument(std::execution::par, ids[remove_count + i]);
+    }));
+}
+
+void WriteJson(std::ostream& out, const BenchmarkOptions& options, const CorpusOptions& corpus_options,
+               const QueryOptions& query_options, const std::vector<OperationResult>& results) {
+    out << "{\n";
+    out << "  \"seed\": " << options.seed << ",\n";
+    out << "  \"hardware_concurrency\": " << std::thread::hardware_concurrency() << ",\n";
+    out << "  \"corpus\": {\"vocabulary_size\": " << corpus_options.vocabulary_size
+        << ", \"zipf_exponent\": " << corpus_options.zipf_exponent
+        << ", \"min_document_words\": " << corpus_options.min_document_words
+        << ", \"max_document_words\": " << corpus_options.max_document_words
+        << ", \"stop_word_count\": " << corpus_options.stop_word_count << "},\n";
+    out << "  \"queries\": {\"count\": " << query_options.query_count
+        << ", \"min_words\": " << query_options.min_words
+        << ", \"max_words\": " << query_options.max_words << "},\n";
+    out << "  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const OperationResult& result = results[i];
+        const double items_per_second = result.seconds > 0.0 ? result.item_count / result.seconds : 0.0;
+        out << (i > 0 ? ",\n" : "\n")
+            << "    {\"operation\": \"" << result.operation << "\""
+            << ", \"documents\": " << result.document_count
+            << ", \"threads\": " << result.thread_count
+            << ", \"operations\": " << result.operation_count
+            << ", \"items\": " << result.item_count
+            << ", \"seconds\": " << result.seconds
+            << ", \"items_per_second\": " << items_per_second
+            << ", \"latency_ns\": {\"mean\": " << result.latency.mean_ns
+            << ", \"p50\": " << result.latency.p50_ns
+            << ", \"p90\": " << result.latency.p90_ns
+            << ", \"p99\": " << result.latency.p99_ns
+            << ", \"max\": " << result.latency.max_ns << "}"
+            << ", \"peak_rss_kb\": " << result.peak_rss_kb << "}";
+    }
+    // Пусто, если сервер собран без SEARCH_SERVER_METRICS
+    out << "\n  ],\n  \"metrics\": " << MetricsRegistry::Global().DumpJson() << "\n}\n";
+}
+
+std::vector<size_t> ParseSizeList(const std::string& text) {
+    std::vector<size_t> values;
+    std::istringstream in(text);
+    for (std::string item; std::getline(in, item, ',');) {
+        values.push_back(std::stoul(item));
+    }
+    if (values.empty() || std::find(values.begin(), values.end(), 0) != values.end()) {
+        throw std::invalid_argument("Expected a comma-separated list of positive numbers: " + text);
+    }
+    return values;
+}
+
+void PrintUsage() {
+    std::cerr << "Usage: search_server_benchmark [--sizes=1000,10000,100000] [--threads=1,8]\n"
+                 "                              [--queries=1000] [--seed=42] [--output=result.json]\n";
+}
+
+BenchmarkOptions ParseOptions(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const size_t equals = arg.find('=');
+        const std::string name = arg.substr(0, equals);
+        const std::string value = equals == std::string::npos ? std::string() : arg.substr(equals + 1);
+        if (name == "--sizes") {
+            options.corpus_sizes = ParseSizeList(value);
+        }
+        else if (name == "--threads") {
+            options.thread_counts = ParseSizeList(value);
+        }
+        else if (name == "--queries") {
+            options.query_count = std::stoul(value);
+        }
+        else if (name == "--seed") {
+            options.seed = std::stoull(value);
+        }
+        else if (name == "--output") {
+            options.output_path = value;
+        }
+        else {
+            throw std::invalid_argument("Unknown option " + arg);
+        }
+    }
+    return options;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    try {
+        options = ParseOptions(argc, argv);
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        PrintUsage();
+        return 1;
+    }
+
+    CorpusOptions corpus_options;
+    corpus_options.seed = options.seed;
+    QueryOptions query_options;
+    query_options.seed = options.seed + 1;
+    query_options.query_count = options.query_count;
+
+    std::vector<OperationResult> results;
+    for (const size_t corpus_size : options.corpus_sizes) {
+        corpus_options.document_count = corpus_size;
+        const SyntheticCorpus corpus = GenerateCorpus(corpus_options);
+        const std::vector<std::string> queries = GenerateQueries(corpus, query_options);
+        for (const size_t thread_count : options.thread_counts) {
+            std::cerr << "documents=" << corpus_size << " threads=" << thread_count << std::endl;
+            RunCorpusBenchmarks(options, corpus, queries, thread_count, results);
+        }
+    }
+
+    if (options.output_path.empty()) {
+        WriteJson(std::cout, options, corpus_options, query_options, results);
+        return 0;
+    }
+    std::ofstream out(options.output_path);
+    WriteJson(out, options, corpus_options, query_options, results);
+    if (!out) {
+        std::cerr << "Cannot write " << options.output_path << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include "corpus_generator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+// Слово ранга rank: запись rank + 1 в биективной системе по основанию 26.
+// Частые слова получаются короткими, как в естественном языке
+std::string MakeWord(size_t rank) {
+    std::string word;
+    for (size_t value = rank + 1; value > 0; value = (value - 1) / 26) {
+        word += static_cast<char>('a' + (value - 1) % 26);
+    }
+    return word;
+}
+
+DocumentStatus PickStatus(BenchmarkRandom& random, const std::array<double, 4>& weights) {
+    double total = 0.0;
+    for (const double weight : weights) {
+        total += weight;
+    }
+    double value = random.NextDouble() * total;
+    for (size_t i = 0; i + 1 < weights.size(); ++i) {
+        if (value < weights[i]) {
+            return static_cast<DocumentStatus>(i);
+        }
+        value -= weights[i];
+    }
+    return static_cast<DocumentStatus>(weights.size() - 1);
+}
+
+} // namespace
+
+ZipfDistribution::ZipfDistribution(size_t size, double exponent)
+    : cumulative_(size) {
+    if (size == 0) {
+        throw std::invalid_argument("Zipf distribution needs at least one rank");
+    }
+    double total = 0.0;
+    for (size_t rank = 0; rank < size; ++rank) {
+        total += 1.0 / std::pow(static_cast<double>(rank + 1), exponent);
+        cumulative_[rank] = total;
+    }
+    for (double& value : cumulative_) {
+        value /= total;
+    }
+}
+
+size_t ZipfDistribution::operator()(BenchmarkRandom& random) const {
+    const double value = random.NextDouble();
+    const auto it = std::upper_bound(cumulative_.begin(), cumulative_.end(), value);
+    return std::min(static_cast<size_t>(it - cumulative_.begin()), cumulative_.size() - 1);
+}
+
+SyntheticCorpus GenerateCorpus(const CorpusOptions& options) {
+    if (options.min_document_words == 0 || options.min_document_words > options.max_document_words
+        || options.min_rating > options.max_rating || options.stop_word_count >= options.vocabulary_size) {
+        throw std::invalid_argument("Invalid corpus options");
+    }
+    SyntheticCorpus corpus;
+    corpus.vocabulary.reserve(options.vocabulary_size);
+    for (size_t rank = 0; rank < options.vocabulary_size; ++rank) {
+        corpus.vocabulary.push_back(MakeWord(rank));
+    }
+    for (size_t rank = 0; rank < options.stop_word_count; ++rank) {
+        if (rank > 0) {
+            corpus.stop_words += ' ';
+        }
+        corpus.stop_words += corpus.vocabulary[rank];
+    }
+
+    BenchmarkRandom random(options.seed);
+    const ZipfDistribution word_ranks(options.vocabulary_size, options.zipf_exponent);
+    corpus.documents.reserve(options.document_count);
+    for (size_t i = 0; i < options.document_count; ++i) {
+        SyntheticDocument& document = corpus.documents.emplace_back();
+        document.id = static_cast<int>(i);
+        const auto word_count = static_cast<size_t>(random.NextInt(
+            static_cast<int64_t>(options.min_document_words), static_cast<int64_t>(options.max_document_words)));
+        for (size_t k = 0; k < word_count; ++k) {
+            if (k > 0) {
+                document.text += ' ';
+            }
+            document.text += corpus.vocabulary[word_ranks(random)];
+        }
+        document.status = PickStatus(random, options.status_weights);
+        const auto rating_count = static_cast<size_t>(random.NextInt(0, static_cast<int64_t>(options.max_rating_count)));
+        for (size_t k = 0; k < rating_count; ++k) {
+            document.ratings.push_back(static_cast<int>(random.NextInt(options.min_rating, options.max_rating)));
+        }
+    }
+    return corpus;
+}
+
+std::vector<std::string> GenerateQueries(const SyntheticCorpus& corpus, const QueryOptions& options) {
+    if (options.min_words == 0 || options.min_words > options.max_words || corpus.vocabulary.empty()) {
+        throw std::invalid_argument("Invalid query options");
+    }
+    BenchmarkRandom random(options.seed);
+    const ZipfDistribution word_ranks(corpus.vocabulary.size(), options.zipf_exponent);
+    std::vector<std::string> queries(options.query_count);
+    for (std::string& query : queries) {
+        const auto word_count = static_cast<size_t>(random.NextInt(
+            static_cast<int64_t>(options.min_words), static_cast<int64_t>(options.max_words)));
+        for (size_t k = 0; k < word_count; ++k) {
+            if (k > 0) {
+                query += ' ';
+            }
+            const double kind = random.NextDouble();
+            if (kind < options.minus_word_share) {
+                query += '-';
+            }
+            else if (kind < options.minus_word_share + options.required_word_share) {
+                query += '+';
+            }
+            query += corpus.vocabulary[word_ranks(random)];
+        }
+    }
+    return queries;
+}
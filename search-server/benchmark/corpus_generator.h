@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "document.h"
+
+// Генератор псевдослучайных чисел бенчмарка. Распределения считаются своим
+// кодом, а не через std::*_distribution, чьи алгоритмы зависят от стандартной
+// библиотеки: так один и тот же seed даёт один и тот же корпус везде
+class BenchmarkRandom {
+public:
+    explicit BenchmarkRandom(uint64_t seed)
+        : engine_(seed) {
+    }
+
+    // Равномерно на [0, 1)
+    double NextDouble() {
+        return static_cast<double>(engine_() >> 11) * 0x1.0p-53;
+    }
+
+    // Равномерно на [min, max]
+    int64_t NextInt(int64_t min, int64_t max) {
+        return min + static_cast<int64_t>(engine_() % static_cast<uint64_t>(max - min + 1));
+    }
+
+private:
+    std::mt19937_64 engine_;
+};
+
+// Закон Ципфа: слово ранга r (с нуля) выпадает с вероятностью,
+// пропорциональной 1 / (r + 1)^exponent
+class ZipfDistribution {
+public:
+    ZipfDistribution(size_t size, double exponent);
+
+    size_t operator()(BenchmarkRandom& random) const;
+
+private:
+    std::vector<double> cumulative_; // нарастающие вероятности рангов
+};
+
+struct CorpusOptions {
+    uint64_t seed = 42;
+    size_t document_count = 10000;
+    size_t vocabulary_size = 50000;
+    double zipf_exponent = 1.0;
+    // Длина документа в словах, равномерно в [min, max]
+    size_t min_document_words = 10;
+    size_t max_document_words = 100;
+    // Доли статусов ACTUAL, IRRELEVANT, BANNED, REMOVED
+    std::array<double, 4> status_weights = { 0.85, 0.05, 0.05, 0.05 };
+    // Каждая оценка равномерна в [min_rating, max_rating], оценок от 0 до max_rating_count
+    int min_rating = -10;
+    int max_rating = 10;
+    size_t max_rating_count = 5;
+    // Стоп-слова — самые частые слова словаря
+    size_t stop_word_count = 20;
+};
+
+struct QueryOptions {
+    uint64_t seed = 7;
+    size_t query_count = 1000;
+    double zipf_exponent = 1.0;
+    size_t min_words = 1;
+    size_t max_words = 5;
+    // Вероятность того, что слово запроса минус-слово или обязательное
+    double minus_word_share = 0.1;
+    double required_word_share = 0.05;
+};
+
+struct SyntheticDocument {
+    int id;
+    std::string text;
+    DocumentStatus status;
+    std::vector<int> ratings;
+};
+
+struct SyntheticCorpus {
+    std::vector<std::string> vocabulary; // по убыванию частоты
+    std::string stop_words;              // через пробел, для конструктора SearchServer
+    std::vector<SyntheticDocument> documents;
+};
+
+SyntheticCorpus GenerateCorpus(const CorpusOptions& options);
+
+// Запросы по словарю корпуса; стоп-слова в них встречаются с той же частотой, что и в документах
+std::vector<std::string> GenerateQueries(const SyntheticCorpus& corpus, const QueryOptions& options);
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "document.h"
+#include "search_server.h"
+
+// Сервер, который можно опрашивать во время обновлений (схема left-right).
+// Индекс хранится в двух одинаковых копиях: читатели работают с активной, а
+// единственный писатель меняет резервную, переключает на неё читателей, дожидается
+// ухода читателей старой копии и повторяет на ней ту же операцию. Чтение не берёт
+// блокировок и не ждёт писателя: вход и выход — по одному атомарному счётчику, и
+// всё время чтения копия неизменна. Платой служат двойная память (страницы
+// отображённого файла копии делят) и двойная работа писателя, который к тому же
+// ждёт завершения самого долгого чтения старой копии
+class ConcurrentSearchServer {
+public:
+    template <typename StringContainer>
+    explicit ConcurrentSearchServer(const StringContainer& stop_words);
+    explicit ConcurrentSearchServer(const std::string& stop_words_text);
+
+    // Обе копии отображают один файл, см. SearchServer::OpenIndex
+    static ConcurrentSearchServer OpenIndex(const std::string& path, bool verify = false);
+
+    ConcurrentSearchServer(const ConcurrentSearchServer&) = delete;
+    ConcurrentSearchServer& operator=(const ConcurrentSearchServer&) = delete;
+
+    // Вызывает func(const SearchServer&) на согласованном снимке индекса и
+    // возвращает её результат. Писатель ждёт, пока func не завершится, поэтому
+    // изнутри func нельзя вызывать изменяющие методы. Строки из MatchDocument
+    // остаются действительными и после выхода: термины из словаря не удаляются
+    template <typename Func>
+    auto Read(Func func) const;
+
+    // Применяет func(SearchServer&) к обеим копиям по очереди, так что func должна
+    // менять их одинаково. Вызовы писателей выполняются строго по одному.
+    // Исключение из func пробрасывается, а копия, на которой оно вылетело,
+    // заменяется копией другой, так что копии не расходятся. С первой копии
+    // изменение не публикуется; со второй оно уже видно читателям и остаётся.
+    // Если не удалось и копирование, Write с этого момента бросает
+    // std::runtime_error, а чтение продолжает работать с опубликованной копией
+    template <typename Func>
+    void Write(Func func);
+
+    template <typename... Args>
+    std::vector<Document> FindTopDocuments(Args&&... args) const;
+
+    // Копии меняются одинаково, поэтому курсор одной годится и для другой
+    template <typename... Args>
+    SearchPage FindPage(Args&&... args) const;
+
+    template <typename... Args>
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(Args&&... args) const;
+
+    // Запрос годится для обеих копий: стоп-слова у них общие, а слова сверяются
+    // со словарём копии, на которой выполняется запрос
+    PreparedQuery PrepareQuery(std::string_view raw_query) const;
+
+    int GetDocumentCount() const;
+    void SaveIndex(const std::string& path) const;
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    void AddDocuments(const std::vector<NewDocument>& documents);
+
+    void RemoveDocument(int document_id);
+    template <typename ExecutionPolicy>
+    void RemoveDocument(ExecutionPolicy&& policy, int document_id);
+
+    void RemoveDocuments(const std::vector<int>& document_ids);
+    template <typename ExecutionPolicy>
+    void RemoveDocuments(ExecutionPolicy&& policy, const std::vector<int>& document_ids);
+
+    void CompactIndex();
+
+    void SetRankingMode(RankingMode mode);
+    void SetQuerySyntax(QuerySyntax syntax);
+    void SetThreadPool(ThreadPool& thread_pool);
+
+private:
+    // Счётчик читателей, разнесённый по строкам кеша, чтобы потоки, читающие
+    // одновременно, не делили одну строку
+    class ReaderIndicator {
+    public:
+        static constexpr size_t STRIPE_COUNT = 32;
+
+        void Arrive(size_t stripe) {
+            stripes_[stripe].count.fetch_add(1);
+        }
+
+        void Depart(size_t stripe) {
+            stripes_[stripe].count.fetch_sub(1);
+        }
+
+        bool IsEmpty() const;
+
+    private:
+        struct alignas(64) Stripe {
+            std::atomic<int64_t> count = 0;
+        };
+
+        std::array<Stripe, STRIPE_COUNT> stripes_;
+    };
+
+    // Отмечает поток читателем на время жизни
+    class ReadGuard {
+    public:
+        explicit ReadGuard(const ConcurrentSearchServer& server);
+        ~ReadGuard();
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+    private:
+        ReaderIndicator& indicator_;
+        size_t stripe_;
+    };
+
+    ConcurrentSearchServer(SearchServer&& left, SearchServer&& right);
+
+    // Переключает читателей на резервную копию и ждёт, пока старую не покинут все
+    void PublishStandby();
+    // Заменяет копию index, которую не читает никто, копией другой
+    void RestoreInstance(int index);
+
+    // В куче, чтобы копию можно было заменить: SearchServer не присваивается
+    std::unique_ptr<SearchServer> instances_[2];
+    std::atomic<int> active_ = 0; // копия, с которой работают читатели
+    // Два индикатора позволяют писателю дождаться ушедших со старой копии,
+    // не дожидаясь бесконечного потока новых читателей
+    mutable ReaderIndicator readers_[2];
+    std::atomic<int> version_ = 0; // индикатор, в котором отмечаются входящие читатели
+    std::mutex writer_mutex_;
+    bool failed_ = false; // копии разошлись; под writer_mutex_
+};
+
+template <typename StringContainer>
+ConcurrentSearchServer::ConcurrentSearchServer(const StringContainer& stop_words)
+    : instances_{ std::make_unique<SearchServer>(stop_words), std::make_unique<SearchServer>(stop_words) } {
+}
+
+template <typename Func>
+auto ConcurrentSearchServer::Read(Func func) const {
+    ReadGuard guard(*this);
+    return func(static_cast<const SearchServer&>(*instances_[active_.load()]));
+}
+
+template <typename Func>
+void ConcurrentSearchServer::Write(Func func) {
+    std::lock_guard lock(writer_mutex_);
+    if (failed_) {
+        throw std::runtime_error("ConcurrentSearchServer copies diverged after a failed write");
+    }
+    const int standby = 1 - active_.load();
+    try {
+        func(*instances_[standby]);
+    }
+    catch (...) {
+        RestoreInstance(standby);
+        throw;
+    }
+    PublishStandby();
+    try {
+        func(*instances_[1 - standby]);
+    }
+    catch (...) {
+        RestoreInstance(1 - standby);
+        throw;
+    }
+}
+
+template <typename... Args>
+std::vector<Document> ConcurrentSearchServer::FindTopDocuments(Args&&... args) const {
+    return Read([&](const SearchServer& server) {
+        return server.FindTopDocuments(std::forward<Args>(args)...);
+    });
+}
+
+template <typename... Args>
+SearchPage ConcurrentSearchServer::FindPage(Args&&... args) const {
+    return Read([&](const SearchServer& server) {
+        return server.FindPage(std::forward<Args>(args)...);
+    });
+}
+
+template <typename... Args>
+std::tuple<std::vector<std::string_view>, DocumentStatus> ConcurrentSearchServer::MatchDocument(Args&&... args) const {
+    return Read([&](const SearchServer& server) {
+        return server.MatchDocument(std::forward<Args>(args)...);
+    });
+}
+
+template <typename ExecutionPolicy>
+void ConcurrentSearchServer::RemoveDocument(ExecutionPolicy&& policy, int document_id) {
+    Write([&](SearchServer& server) {
+        server.RemoveDocument(policy, document_id);
+    });
+}
+
+template <typename ExecutionPolicy>
+void ConcurrentSearchServer::RemoveDocuments(ExecutionPolicy&& policy, const std::vector<int>& document_ids) {
+    Write([&](SearchServer& server) {
+        server.RemoveDocuments(policy, document_ids);
+    });
+}
@@ -5,6 +5,7 @@
 using namespace std::string_literals;
 
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
+const double DEVIATION = 1e-6;
 
 enum class DocumentStatus {
     ACTUAL,
@@ -22,6 +23,15 @@ struct Document {
     int rating = 0;
 };
 
+// Порядок выдачи: по убыванию релевантности, при почти равной — по убыванию рейтинга,
+// затем по возрастанию id. Без id равные документы упорядочивала бы очерёдность
+// отбора, и последовательный, параллельный и MAX_SCORE поиск выдавали бы разное
+bool IsMoreRelevant(const Document& lhs, const Document& rhs);
+// Строгий полный порядок для постраничной выдачи: релевантность по убыванию без
+// допуска DEVIATION, при равной — рейтинг по убыванию, затем id по возрастанию.
+// IsMoreRelevant из-за допуска не транзитивен и не годится ключом курсора
+bool IsMoreRelevantStrict(const Document& lhs, const Document& rhs);
+
 std::ostream& operator<<(std::ostream& out, const Document& document);
 void PrintDocument(const Document& document);
 void PrintMatchDocumentResult(int document_id, std::vector<std::string_view> words, DocumentStatus status);
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include "document.h"
+
+// Битовая карта по порядковым номерам документов, по 64 номера в слове
+class DocumentBitmap {
+public:
+    void PushBack(bool value) {
+        if (size_ % 64 == 0) {
+            words_.push_back(0);
+        }
+        if (value) {
+            Set(size_);
+        }
+        ++size_;
+    }
+
+    void Set(size_t index) {
+        words_[index / 64] |= uint64_t{ 1 } << (index % 64);
+    }
+
+    void Reset(size_t index) {
+        words_[index / 64] &= ~(uint64_t{ 1 } << (index % 64));
+    }
+
+    bool Test(size_t index) const {
+        return (words_[index / 64] >> (index % 64)) & 1;
+    }
+
+    void Reserve(size_t size) {
+        words_.reserve((size + 63) / 64);
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    // Слова карты; биты за size() нулевые
+    const std::vector<uint64_t>& GetWords() const {
+        return words_;
+    }
+
+private:
+    std::vector<uint64_t> words_;
+    size_t size_ = 0;
+};
+
+// Атрибуты документов по столбцам, индекс — порядковый номер документа.
+// Проход по одному атрибуту читает подряд лежащие значения, а для каждого
+// статуса хранится битовая карта живых документов с этим статусом, так что
+// фильтр по статусу не читает атрибуты вовсе
+class DocumentTable {
+public:
+    static constexpr size_t STATUS_COUNT = static_cast<size_t>(DocumentStatus::REMOVED) + 1;
+
+    void Add(int id, int rating, DocumentStatus status, double inv_word_count, bool is_removed = false);
+    void Reserve(size_t size);
+    // Удалённый документ сохраняет номер и атрибуты, но пропадает из карт статусов
+    void MarkRemoved(int ordinal);
+
+    size_t size() const {
+        return ids_.size();
+    }
+
+    int GetId(int ordinal) const {
+        return ids_[ordinal];
+    }
+
+    int GetRating(int ordinal) const {
+        return ratings_[ordinal];
+    }
+
+    DocumentStatus GetStatus(int ordinal) const {
+        return statuses_[ordinal];
+    }
+
+    // TF термина = число вхождений * inv_word_count
+    double GetInvWordCount(int ordinal) const {
+        return inv_word_counts_[ordinal];
+    }
+
+    bool IsRemoved(int ordinal) const {
+        return is_removed_.Test(ordinal);
+    }
+
+    const std::vector<int>& GetRatings() const {
+        return ratings_;
+    }
+
+    // Живые документы со статусом status
+    const DocumentBitmap& GetStatusBitmap(DocumentStatus status) const {
+        return status_bitmaps_[static_cast<size_t>(status)];
+    }
+
+    const DocumentBitmap& GetLiveBitmap() const {
+        return is_live_;
+    }
+
+private:
+    std::vector<int> ids_;
+    std::vector<int> ratings_;
+    std::vector<DocumentStatus> statuses_;
+    std::vector<double> inv_word_counts_;
+    DocumentBitmap is_removed_;
+    DocumentBitmap is_live_;
+    std::array<DocumentBitmap, STATUS_COUNT> status_bitmaps_;
+};
+
+// Фильтры документов, устройство которых известно серверу. Их можно передать
+// в FindTopDocuments вместо произвольного предиката: сервер узнаёт тип на этапе
+// компиляции и проверяет фильтр по битовой карте, пословным AND до подсчёта
+// релевантности, а не вызовом на каждую запись списка документов
+
+// Живые документы со статусом status
+struct StatusFilter {
+    DocumentStatus status = DocumentStatus::ACTUAL;
+
+    bool operator()(int /*document_id*/, DocumentStatus document_status, int /*rating*/) const {
+        return document_status == status;
+    }
+
+    // Готовая карта таблицы, buffer не используется
+    const std::vector<uint64_t>& GetBitmap(const DocumentTable& table, std::vector<uint64_t>& /*buffer*/) const {
+        return table.GetStatusBitmap(status).GetWords();
+    }
+};
+
+// Живые документы с рейтингом из [min_rating, max_rating] и, если задан, статусом status
+struct RatingRangeFilter {
+    int min_rating = INT_MIN;
+    int max_rating = INT_MAX;
+    std::optional<DocumentStatus> status;
+
+    bool operator()(int /*document_id*/, DocumentStatus document_status, int rating) const {
+        return IsRatingAccepted(rating) && (!status || document_status == *status);
+    }
+
+    // Одно беззнаковое сравнение вместо двух ветвлений: рейтинг за границей
+    // диапазона после вычитания min_rating становится большим беззнаковым числом
+    bool IsRatingAccepted(int rating) const {
+        return min_rating <= max_rating
+            && static_cast<uint32_t>(rating) - static_cast<uint32_t>(min_rating)
+                   <= static_cast<uint32_t>(max_rating) - static_cast<uint32_t>(min_rating);
+    }
+
+    // Карта статуса (или живых документов), пересечённая с картой рейтинга.
+    // Читает весь столбец рейтингов; результат пишется в buffer
+    const std::vector<uint64_t>& GetBitmap(const DocumentTable& table, std::vector<uint64_t>& buffer) const;
+};
+
+template <typename Filter>
+struct IsBitmapFilter : std::false_type {
+};
+
+template <>
+struct IsBitmapFilter<StatusFilter> : std::true_type {
+};
+
+template <>
+struct IsBitmapFilter<RatingRangeFilter> : std::true_type {
+};
+
+template <typename Filter>
+inline constexpr bool IS_BITMAP_FILTER = IsBitmapFilter<std::decay_t<Filter>>::value;
+
+class SearchServer;
+
+// Видимые документы одного сервера, по его порядковым номерам. Владелец
+// неизменяемого индекса (например, сегмента) скрывает в маске удалённые
+// документы, не трогая сам индекс. Строится SearchServer::MakeDocumentMask и
+// годится, пока в сервер не добавлены новые документы
+class DocumentMask {
+public:
+    size_t GetHiddenCount() const {
+        return hidden_count_;
+    }
+
+    const std::vector<uint64_t>& GetWords() const {
+        return visible_.GetWords();
+    }
+
+private:
+    friend class SearchServer;
+
+    DocumentBitmap visible_;
+    size_t hidden_count_ = 0;
+};
+
+// Предикат или фильтр, который проверяется только у документов, видимых в mask.
+// Маска ложится в карту аккумулятора, так что скрытые документы отсекаются
+// без вызова filter; фильтр из списка выше пересекается с маской пословно
+template <typename Filter>
+struct MaskedFilter {
+    const DocumentMask& mask;
+    Filter filter;
+};
+
+template <typename Filter>
+struct IsMaskedFilter : std::false_type {
+};
+
+template <typename Filter>
+struct IsMaskedFilter<MaskedFilter<Filter>> : std::true_type {
+};
+
+template <typename Filter>
+inline constexpr bool IS_MASKED_FILTER = IsMaskedFilter<std::decay_t<Filter>>::value;
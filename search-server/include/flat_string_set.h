@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Множество строк с открытой адресацией для частых проверок вхождения.
+// Строки лежат подряд в одном буфере, а таблица хранит только хеш и границы
+// строки, так что поиск — одно вычисление хеша и несколько соседних ячеек,
+// без обхода дерева и без указателей на чужую память. Объект копируется
+// и перемещается как обычное значение
+class FlatStringSet {
+public:
+    FlatStringSet() = default;
+
+    template <typename StringContainer>
+    explicit FlatStringSet(const StringContainer& strings) {
+        for (const std::string_view str : strings) {
+            Insert(str);
+        }
+    }
+
+    void Insert(std::string_view str);
+    bool Contains(std::string_view str) const;
+
+    size_t size() const {
+        return size_;
+    }
+
+private:
+    struct Slot {
+        uint64_t hash;
+        uint32_t offset;
+        uint32_t length; // EMPTY_SLOT — ячейка свободна
+    };
+
+    static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+
+    static uint64_t Hash(std::string_view str);
+    std::string_view GetString(const Slot& slot) const;
+    void Rehash(size_t slot_count);
+
+    std::string bytes_;
+    std::vector<Slot> slots_; // размер — степень двойки, заполнено не больше половины
+    size_t size_ = 0;
+};
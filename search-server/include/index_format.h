@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Формат файла индекса SearchServer. Числа записаны в порядке байт машины,
+// создавшей файл. Секции выровнены на 8 байт, чтобы записи читались прямо
+// из отображённых страниц. Несовместимые изменения формата повышают версию
+const char INDEX_FILE_MAGIC[8] = { 'S', 'R', 'C', 'H', 'I', 'D', 'X', '\0' };
+const uint32_t INDEX_FILE_VERSION = 2;
+const size_t INDEX_SECTION_ALIGNMENT = 8;
+
+enum IndexSection : uint32_t {
+    STOP_WORD_BYTES,    // стоп-слова подряд
+    STOP_WORD_OFFSETS,  // uint64_t, число стоп-слов + 1
+    TERM_BYTES,         // строки терминов подряд в порядке TermId
+    TERM_OFFSETS,       // uint64_t, число терминов + 1
+    SORTED_TERM_IDS,    // TermId в порядке строк
+    POSTING_LISTS,      // IndexPostingListRecord на каждый TermId
+    POSTING_BLOCKS,     // PostingList::BlockInfo всех списков подряд
+    POSTING_DATA,       // закодированные блоки всех списков подряд
+    DOCUMENTS,          // IndexDocumentRecord на каждый порядковый номер
+    DOCUMENT_TERMS,     // DocumentTerm всех документов подряд
+    DOCUMENT_IDS,       // IndexDocumentId живых документов по возрастанию id
+    INDEX_SECTION_COUNT,
+};
+
+struct IndexSectionInfo {
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct IndexFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t section_count;
+    uint64_t file_size;
+    uint64_t checksum; // ComputeIndexChecksum от всего, что идёт после заголовка
+    IndexSectionInfo sections[INDEX_SECTION_COUNT];
+};
+
+struct IndexPostingListRecord {
+    uint64_t first_block;
+    uint64_t data_offset;
+    uint64_t data_size;
+    uint32_t block_count;
+    uint32_t posting_count;
+    double max_term_freq;
+};
+
+struct IndexDocumentRecord {
+    int32_t id;
+    int32_t rating;
+    int32_t status;
+    uint32_t is_removed;
+    double inv_word_count;
+    uint64_t first_term;
+    uint64_t term_count;
+};
+
+struct IndexDocumentId {
+    int32_t id;
+    int32_t ordinal;
+};
+
+const uint64_t INDEX_CHECKSUM_SEED = 14695981039346656037ull;
+
+// FNV-1a по 64-битным словам, хвост короче слова добивается нулями.
+// Для данных длиной кратной 8 сумму можно продолжать, передавая прошлый результат как seed
+uint64_t ComputeIndexChecksum(const uint8_t* data, size_t size, uint64_t seed = INDEX_CHECKSUM_SEED);
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Файл, отображённый в память только для чтения. Страницы берутся из
+// страничного кеша, поэтому процессы, открывшие один файл, делят их
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const {
+        return data_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Создаёт в каталоге directory пустой файл с новым именем prefix + случайная
+// часть + suffix (см. mkstemps) и возвращает путь к нему. Имя не совпадёт ни
+// с одним существующим файлом, в том числе созданным другим процессом
+std::string CreateUniqueFile(const std::string& directory, const std::string& prefix, const std::string& suffix);
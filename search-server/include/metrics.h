@@ -0,0 +1,157 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Счётчики и гистограммы задержек для замеров на горячем пути. Замеры
+// включаются макросом SEARCH_SERVER_METRICS при сборке; без него макросы
+// METRICS_* ничего не порождают, и сервер не платит за инструментирование.
+// Реестр и классы доступны всегда, так что снимки можно читать и без замеров.
+// Макрос задаётся одинаково для всех единиц трансляции: шаблоны сервера в
+// заголовках тоже содержат замеры.
+//
+// Замеры SearchServer: query.parse (разбор текста запроса), query.term_lookup
+// (поиск слов в словаре), query.minus_filter (фильтр минус- и обязательных слов),
+// query.scoring, query.top_k, index.add_document, index.add_documents,
+// index.remove_document, index.remove_documents, index.renumber_documents
+// (переназначение номеров, входит в замер удаления); счётчики index.documents_added
+// и index.documents_removed
+
+// Снимок гистограммы; перцентили — верхние границы корзин, ошибка не больше 1/32 значения
+struct HistogramSnapshot {
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+    std::vector<uint64_t> bucket_counts;
+
+    double GetMean() const;
+    // Значение, которого не превышает доля share всех замеров, share из [0, 1]
+    uint64_t GetPercentile(double share) const;
+};
+
+// Гистограмма неотрицательных значений (наносекунд) в духе HdrHistogram:
+// значение попадает в корзину по старшему биту и следующим SUB_BUCKET_BITS
+// битам, так что корзины растут вместе со значением, а относительная ошибка
+// постоянна. Запись — пара атомарных сложений без блокировок
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr uint64_t SUB_BUCKET_COUNT = uint64_t{ 1 } << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKET_COUNT = SUB_BUCKET_COUNT * (64 - SUB_BUCKET_BITS + 1);
+
+    void Record(uint64_t value) {
+        buckets_[GetBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+        uint64_t max = max_.load(std::memory_order_relaxed);
+        while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    // Замеры, идущие одновременно со снимком, могут попасть в него частично
+    HistogramSnapshot GetSnapshot() const;
+    void Reset();
+
+    static size_t GetBucketIndex(uint64_t value);
+    // Наибольшее значение, попадающее в корзину
+    static uint64_t GetBucketUpperBound(size_t index);
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_{};
+    std::atomic<uint64_t> sum_ = 0;
+    std::atomic<uint64_t> max_ = 0;
+};
+
+class MetricsCounter {
+public:
+    void Add(uint64_t value) {
+        value_.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    uint64_t Get() const {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+    void Reset() {
+        value_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> value_ = 0;
+};
+
+struct MetricsSnapshot {
+    std::map<std::string, HistogramSnapshot> histograms;
+    std::map<std::string, uint64_t> counters;
+};
+
+// Именованные метрики процесса. Получение метрики по имени берёт мьютекс,
+// поэтому код запоминает ссылку один раз (макросы ниже кладут её в статическую
+// переменную), а дальше пишет в метрику без блокировок. Метрики не удаляются,
+// ссылки действительны до конца работы процесса
+class MetricsRegistry {
+public:
+    static MetricsRegistry& Global();
+
+    LatencyHistogram& GetHistogram(std::string_view name);
+    MetricsCounter& GetCounter(std::string_view name);
+
+    MetricsSnapshot GetSnapshot() const;
+    // Строка на метрику: имя, число замеров, среднее, p50, p90, p99, максимум в наносекундах
+    std::string DumpText() const;
+    std::string DumpJson() const;
+    // Обнуляет значения, не удаляя метрик
+    void Reset();
+
+private:
+    mutable std::mutex mutex_;
+    std::map<std::string, std::unique_ptr<LatencyHistogram>, std::less<>> histograms_;
+    std::map<std::string, std::unique_ptr<MetricsCounter>, std::less<>> counters_;
+};
+
+// Записывает в гистограмму время жизни объекта в наносекундах
+class ScopedTimer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit ScopedTimer(LatencyHistogram& histogram)
+        : histogram_(histogram) {
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    ~ScopedTimer() {
+        histogram_.Record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_).count()));
+    }
+
+private:
+    LatencyHistogram& histogram_;
+    const Clock::time_point start_ = Clock::now();
+};
+
+#define METRICS_CONCAT_INTERNAL(X, Y) X ## Y
+#define METRICS_CONCAT(X, Y) METRICS_CONCAT_INTERNAL(X, Y)
+
+#ifdef SEARCH_SERVER_METRICS
+// Замеряет время до конца текущей области видимости
+#define METRICS_SCOPED_TIMER(name) \
+    static LatencyHistogram& METRICS_CONCAT(metricsHistogram, __LINE__) = MetricsRegistry::Global().GetHistogram(name); \
+    ScopedTimer METRICS_CONCAT(metricsTimer, __LINE__)(METRICS_CONCAT(metricsHistogram, __LINE__))
+#define METRICS_COUNTER_ADD(name, value) \
+    do { \
+        static MetricsCounter& metrics_counter = MetricsRegistry::Global().GetCounter(name); \
+        metrics_counter.Add(value); \
+    } while (false)
+#else
+#define METRICS_SCOPED_TIMER(name) static_cast<void>(0)
+#define METRICS_COUNTER_ADD(name, value) static_cast<void>(0)
+#endif
@@ -1,4 +1,14 @@
 #pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include "search_cursor.h"
  
 template <typename Iterator>
 class IteratorRange {
@@ -68,3 +78,82 @@ template <typename Container>
 auto Paginate(const Container& c, size_t page_size) {
     return Paginator(begin(c), end(c), page_size);
 }
+
+// Постраничный обход выдачи по курсору. Страница запрашивается у fetch_page(cursor),
+// когда итератор до неё доходит, поэтому обход можно прервать на любой странице,
+// не считая остальных. Страницы — IteratorRange, как у Paginator; обход однопроходный
+template <typename FetchPage>
+class CursorPaginator {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = IteratorRange<std::vector<Document>::const_iterator>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = value_type;
+
+        // Конец обхода
+        Iterator() = default;
+
+        explicit Iterator(const FetchPage* fetch_page)
+            : fetch_page_(fetch_page) {
+            Fetch(SearchCursor());
+        }
+
+        value_type operator*() const {
+            return { page_->documents.begin(), page_->documents.end() };
+        }
+
+        Iterator& operator++() {
+            if (page_->is_last) {
+                page_.reset();
+            }
+            else {
+                Fetch(page_->next);
+            }
+            return *this;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return page_ == other.page_;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        void Fetch(const SearchCursor& cursor) {
+            auto page = std::make_shared<SearchPage>((*fetch_page_)(cursor));
+            page_ = page->documents.empty() ? nullptr : std::move(page);
+        }
+
+        const FetchPage* fetch_page_ = nullptr;
+        std::shared_ptr<const SearchPage> page_; // nullptr в конце
+    };
+
+    explicit CursorPaginator(FetchPage fetch_page)
+        : fetch_page_(std::move(fetch_page)) {
+    }
+
+    Iterator begin() const {
+        return Iterator(&fetch_page_);
+    }
+
+    Iterator end() const {
+        return Iterator();
+    }
+
+private:
+    FetchPage fetch_page_;
+};
+
+// Обходит страницами по page_size выдачу server.FindPage(query, курсор, page_size, filter...);
+// server — SearchServer или ConcurrentSearchServer, он должен пережить обход
+template <typename SearchServerType, typename QueryType, typename... Filter>
+auto PaginateSearch(const SearchServerType& server, QueryType query, size_t page_size, Filter... filter) {
+    return CursorPaginator([&server, query = std::move(query), page_size, filter...](const SearchCursor& cursor) {
+        return server.FindPage(query, cursor, page_size, filter...);
+    });
+}
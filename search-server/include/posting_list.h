@@ -0,0 +1,266 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+struct Posting {
+    int ordinal = 0;
+    uint32_t term_count = 0;
+};
+
+// Список документов одного термина. Порядковые номера документов хранятся
+// отсортированными блоками по BLOCK_SIZE записей: разность с предыдущим номером
+// и число вхождений термина кодируются varint. Для каждого блока есть запись
+// в индексе пропусков, а добавления в конец копятся в несжатом хвосте
+class PostingList {
+public:
+    static constexpr size_t BLOCK_SIZE = 128;
+
+    // Запись индекса пропусков. Хранится в файле индекса как есть, поэтому
+    // раскладка полей — часть формата файла
+    struct BlockInfo {
+        int first_ordinal;
+        int last_ordinal;
+        uint32_t offset; // от начала закодированных данных списка
+        uint32_t count;
+        double max_term_freq;
+    };
+
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Posting;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Posting*;
+        using reference = const Posting&;
+
+        Iterator() = default;
+
+        reference operator*() const {
+            return current_;
+        }
+
+        pointer operator->() const {
+            return &current_;
+        }
+
+        Iterator& operator++() {
+            ++index_;
+            if (block_ < block_count_) {
+                if (index_ < blocks_[block_].count) {
+                    current_.ordinal += static_cast<int>(ReadVarint(cursor_));
+                    current_.term_count = ReadVarint(cursor_);
+                    return *this;
+                }
+                ++block_;
+                index_ = 0;
+            }
+            Load();
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool IsEnd() const {
+            return block_ == block_count_ && index_ >= list_->tail_.size();
+        }
+
+        // Сдвигает итератор к первой записи с номером не меньше ordinal,
+        // целиком пропуская блоки, которые заканчиваются раньше
+        void AdvanceTo(int ordinal) {
+            if (block_ < block_count_ && blocks_[block_].last_ordinal < ordinal) {
+                block_ = list_->FindBlock(ordinal, block_ + 1);
+                index_ = 0;
+                Load();
+            }
+            while (!IsEnd() && current_.ordinal < ordinal) {
+                ++*this;
+            }
+        }
+
+        // Верхняя граница TF в блоке, где должна лежать запись ordinal.
+        // Итератор при этом не двигается и ничего не распаковывает
+        double PeekBlockMaxTermFreq(int ordinal) const {
+            size_t block = block_;
+            if (block < block_count_ && blocks_[block].last_ordinal < ordinal) {
+                block = list_->FindBlock(ordinal, block + 1);
+            }
+            return block < block_count_ ? blocks_[block].max_term_freq : list_->tail_max_term_freq_;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return block_ == other.block_ && index_ == other.index_;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        friend class PostingList;
+
+        Iterator(const PostingList* list, size_t block, uint32_t index)
+            : list_(list)
+            , blocks_(list->GetBlocks())
+            , data_(list->GetData())
+            , block_count_(list->GetBlockCount())
+            , block_(block)
+            , index_(index) {
+            Load();
+        }
+
+        // Встаёт на начало блока block_ (index_ == 0) или на элемент хвоста
+        void Load();
+
+        const PostingList* list_ = nullptr;
+        // Копии указателей списка, чтобы не выбирать на каждом шаге между своей и отображённой памятью
+        const BlockInfo* blocks_ = nullptr;
+        const uint8_t* data_ = nullptr;
+        size_t block_count_ = 0;
+        size_t block_ = 0;
+        uint32_t index_ = 0;
+        const uint8_t* cursor_ = nullptr;
+        Posting current_;
+    };
+
+    // Добавляет документ или заменяет число вхождений у уже имеющегося.
+    // term_freq нужен только для верхних границ TF в блоках
+    void Add(int ordinal, uint32_t term_count, double term_freq);
+
+    bool Contains(int ordinal) const;
+    // Первая запись с номером не меньше ordinal, поиск идёт по индексу пропусков
+    Iterator LowerBound(int ordinal) const;
+
+    Iterator begin() const {
+        return Iterator(this, 0, 0);
+    }
+
+    Iterator end() const {
+        return Iterator(this, GetBlockCount(), static_cast<uint32_t>(tail_.size()));
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    // Распаковывает порядковые номера всех документов списка
+    void DecodeOrdinals(std::vector<int>& ordinals) const;
+
+    // Верхняя граница TF по всему списку. После удалений может быть завышена
+    double GetMaxTermFreq() const {
+        return max_term_freq_;
+    }
+
+    // Память в куче; отображённые из файла блоки не учитываются
+    size_t GetMemoryUsage() const;
+
+    // Перекодирует список за один проход без записей, для которых is_removed(ordinal)
+    // истинно. Границы TF блоков пересчитываются через term_freq(posting)
+    template <typename RemovedPredicate, typename TermFreqFunc>
+    void Compact(RemovedPredicate is_removed, TermFreqFunc term_freq);
+    // То же с заменой номеров на new_ordinal(ordinal); -1 — запись удаляется.
+    // Новые номера должны идти в том же порядке, что и старые. term_freq получает
+    // запись со старым номером
+    template <typename OrdinalMap, typename TermFreqFunc>
+    void Renumber(OrdinalMap new_ordinal, TermFreqFunc term_freq);
+
+    // Дописывает список в плоском виде для файла индекса: блоки со смещениями
+    // относительно начала его данных, несжатый хвост кодируется последним блоком
+    void Export(std::vector<BlockInfo>& blocks, std::vector<uint8_t>& data) const;
+
+    // Список поверх чужой памяти, например отображённого файла индекса. Память
+    // должна пережить список. Первое изменение копирует данные в свою память
+    static PostingList Map(const BlockInfo* blocks, size_t block_count, const uint8_t* data, size_t data_size,
+                           size_t posting_count, double max_term_freq);
+
+    // Можно ли отдать эти данные Map: блоки не выходят за data, номера в них
+    // возрастают, лежат в [0, ordinal_count) и совпадают с границами блоков,
+    // а записей ровно posting_count. Распаковывает все блоки
+    static bool IsValidMapping(const BlockInfo* blocks, size_t block_count, const uint8_t* data, size_t data_size,
+                               size_t posting_count, int ordinal_count);
+
+private:
+    static uint32_t ReadVarint(const uint8_t*& cursor) {
+        uint32_t value = *cursor & 0x7F;
+        for (int shift = 7; *cursor++ & 0x80; shift += 7) {
+            value |= static_cast<uint32_t>(*cursor & 0x7F) << shift;
+        }
+        return value;
+    }
+
+    const BlockInfo* GetBlocks() const {
+        return mapped_blocks_ != nullptr ? mapped_blocks_ : blocks_.data();
+    }
+
+    size_t GetBlockCount() const {
+        return mapped_blocks_ != nullptr ? mapped_block_count_ : blocks_.size();
+    }
+
+    const uint8_t* GetData() const {
+        return mapped_blocks_ != nullptr ? mapped_data_ : data_.data();
+    }
+
+    size_t GetDataSize() const {
+        return mapped_blocks_ != nullptr ? mapped_data_size_ : data_.size();
+    }
+
+    // Переносит отображённые данные в свою память перед изменением
+    void Detach();
+    size_t FindBlock(int ordinal, size_t first_block = 0) const;
+    std::vector<Posting> DecodeBlock(size_t block_index) const;
+    // Перекодирует блок, при необходимости разбивая его на несколько
+    void ReplaceBlock(size_t block_index, const std::vector<Posting>& postings);
+    void FlushTail();
+
+    std::vector<uint8_t> data_;
+    std::vector<BlockInfo> blocks_;
+    std::vector<Posting> tail_;
+    double tail_max_term_freq_ = 0.0;
+    double max_term_freq_ = 0.0;
+    size_t size_ = 0;
+    // Отображённые блоки; если заданы, data_ и blocks_ пусты
+    const BlockInfo* mapped_blocks_ = nullptr;
+    size_t mapped_block_count_ = 0;
+    const uint8_t* mapped_data_ = nullptr;
+    size_t mapped_data_size_ = 0;
+};
+
+inline void PostingList::Iterator::Load() {
+    if (block_ < block_count_) {
+        const BlockInfo& block = blocks_[block_];
+        cursor_ = data_ + block.offset;
+        current_.ordinal = block.first_ordinal + static_cast<int>(ReadVarint(cursor_));
+        current_.term_count = ReadVarint(cursor_);
+    }
+    else if (index_ < list_->tail_.size()) {
+        current_ = list_->tail_[index_];
+    }
+}
+
+template <typename RemovedPredicate, typename TermFreqFunc>
+void PostingList::Compact(RemovedPredicate is_removed, TermFreqFunc term_freq) {
+    Renumber([&is_removed](int ordinal) { return is_removed(ordinal) ? -1 : ordinal; }, term_freq);
+}
+
+template <typename OrdinalMap, typename TermFreqFunc>
+void PostingList::Renumber(OrdinalMap new_ordinal, TermFreqFunc term_freq) {
+    // Номера идут по возрастанию, поэтому Add только дописывает хвост
+    PostingList renumbered;
+    for (const Posting& posting : *this) {
+        const int ordinal = new_ordinal(posting.ordinal);
+        if (ordinal >= 0) {
+            renumbered.Add(ordinal, posting.term_count, term_freq(posting));
+        }
+    }
+    *this = std::move(renumbered);
+}
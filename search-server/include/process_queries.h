@@ -1,14 +1,124 @@
 #pragma once
 
+#include "concurrent_search_server.h"
 #include "document.h"
 #include "search_server.h"
 
+#include <algorithm>
+#include <mutex>
+#include <string_view>
 #include <vector>
 
+// Результаты пакета запросов в одном плоском буфере:
+// документы i-го запроса лежат в documents[offsets[i], offsets[i + 1])
+struct QueryBatchResult {
+    std::vector<Document> documents;
+    std::vector<size_t> offsets;
+
+    size_t GetQueryCount() const {
+        return offsets.empty() ? 0 : offsets.size() - 1;
+    }
+};
+
+enum class ResultOrder {
+    IN_ORDER,     // в порядке запросов, как только готов очередной префикс
+    AS_COMPLETED, // сразу по готовности, номер запроса передаётся в приёмник
+};
+
 std::vector<std::vector<Document>> ProcessQueries(
     const SearchServer& search_server,
-    const std::vector<std::string>& queries); 
+    const std::vector<std::string>& queries);
 
 std::vector<Document> ProcessQueriesJoined(
     const SearchServer& search_server,
     const std::vector<std::string>& queries);
+
+// Весь пакет выполняется на одном снимке индекса; обновления, пришедшие во
+// время пакета, дожидаются его завершения
+std::vector<std::vector<Document>> ProcessQueries(
+    const ConcurrentSearchServer& search_server,
+    const std::vector<std::string>& queries);
+
+std::vector<Document> ProcessQueriesJoined(
+    const ConcurrentSearchServer& search_server,
+    const std::vector<std::string>& queries);
+
+// Выполняет запросы в пуле сервера и передаёт результат каждого в
+// sink(size_t query_index, std::vector<Document>&& documents). Вызовы приёмника
+// идут по одному, так что ему не нужна своя синхронизация. queries — любой
+// контейнер с произвольным доступом из PreparedQuery или элементов, приводимых
+// к string_view. Разобранные заранее запросы не разбираются при каждом пакете
+template <typename QueryContainer, typename Sink>
+void ProcessQueriesStreamed(
+    const SearchServer& search_server,
+    const QueryContainer& queries,
+    Sink&& sink,
+    ResultOrder order = ResultOrder::IN_ORDER);
+
+// Результаты всех запросов подряд, без промежуточного вектора на каждый запрос
+template <typename QueryContainer>
+QueryBatchResult ProcessQueriesFlat(
+    const SearchServer& search_server,
+    const QueryContainer& queries);
+
+inline std::vector<Document> FindBatchQueryDocuments(const SearchServer& search_server, std::string_view query) {
+    return search_server.FindTopDocuments(query);
+}
+
+inline std::vector<Document> FindBatchQueryDocuments(const SearchServer& search_server, const PreparedQuery& query) {
+    return search_server.FindTopDocuments(query);
+}
+
+template <typename QueryContainer, typename Sink>
+void ProcessQueriesStreamed(
+    const SearchServer& search_server,
+    const QueryContainer& queries,
+    Sink&& sink,
+    ResultOrder order) {
+    // Упорядоченная выдача идёт окнами: ждать отстающий запрос приходится
+    // только внутри окна, и буферизуется не больше одного окна результатов
+    static constexpr size_t WINDOW_PER_THREAD = 256;
+
+    ThreadPool& pool = search_server.GetThreadPool();
+    std::mutex sink_mutex;
+    if (order == ResultOrder::AS_COMPLETED) {
+        pool.ParallelFor(queries.size(), [&](size_t i) {
+            auto documents = FindBatchQueryDocuments(search_server, queries[i]);
+            std::lock_guard lock(sink_mutex);
+            sink(i, std::move(documents));
+        });
+        return;
+    }
+
+    const size_t window = std::min((pool.GetThreadCount() + 1) * WINDOW_PER_THREAD, queries.size());
+    std::vector<std::vector<Document>> slots(window);
+    std::vector<bool> ready(window);
+    for (size_t window_begin = 0; window_begin < queries.size(); window_begin += window) {
+        const size_t window_size = std::min(window, queries.size() - window_begin);
+        std::fill(ready.begin(), ready.end(), false);
+        size_t next_to_emit = 0;
+        pool.ParallelFor(window_size, [&](size_t i) {
+            auto documents = FindBatchQueryDocuments(search_server, queries[window_begin + i]);
+            std::lock_guard lock(sink_mutex);
+            slots[i] = std::move(documents);
+            ready[i] = true;
+            for (; next_to_emit < window_size && ready[next_to_emit]; ++next_to_emit) {
+                sink(window_begin + next_to_emit, std::move(slots[next_to_emit]));
+            }
+        });
+    }
+}
+
+template <typename QueryContainer>
+QueryBatchResult ProcessQueriesFlat(
+    const SearchServer& search_server,
+    const QueryContainer& queries) {
+    QueryBatchResult result;
+    result.offsets.reserve(queries.size() + 1);
+    result.offsets.push_back(0);
+    ProcessQueriesStreamed(search_server, queries, [&result](size_t, std::vector<Document>&& documents) {
+        result.documents.insert(result.documents.end(), documents.begin(), documents.end());
+        result.offsets.push_back(result.documents.size());
+    });
+    return result;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "small_vector.h"
+#include "term_dictionary.h"
+
+// Слово запроса и его идентификатор в словаре сервера; NO_TERM — слова в словаре нет
+struct QueryTerm {
+    std::string_view word;
+    TermId term_id = TermDictionary::NO_TERM;
+};
+
+// Столько слов каждого вида разбираются без выделения памяти
+inline constexpr size_t INLINE_QUERY_TERM_COUNT = 8;
+
+using QueryTerms = SmallVector<QueryTerm, INLINE_QUERY_TERM_COUNT>;
+
+// Разобранный запрос: слова каждого вида без стоп-слов и повторов, по возрастанию.
+// При QuerySyntax::REQUIRED_TERMS слово с префиксом '+' обязательно: документ без
+// него не попадёт в выдачу.
+// Обязательные слова входят и в plus_terms, так как участвуют в релевантности
+struct Query {
+    QueryTerms plus_terms;
+    QueryTerms minus_terms;
+    QueryTerms required_terms;
+};
+
+// Запрос, разобранный один раз для многократного выполнения, например в пакете
+// ProcessQueries или при постраничной выдаче. Хранит копию текста, так что
+// исходную строку можно освободить. Стоп-слова и разделители — того сервера,
+// который разобрал запрос; идентификаторы слов сверяются со словарём сервера,
+// выполняющего запрос, и при расхождении находятся заново. Объект неизменяем,
+// копии делят текст, и один запрос можно выполнять из нескольких потоков
+class PreparedQuery {
+public:
+    PreparedQuery() = default;
+
+    std::string_view GetText() const {
+        return text_ != nullptr ? std::string_view(*text_) : std::string_view();
+    }
+
+    const Query& GetQuery() const {
+        return query_;
+    }
+
+private:
+    friend class SearchServer;
+
+    PreparedQuery(std::shared_ptr<const std::string> text, Query query)
+        : text_(std::move(text))
+        , query_(std::move(query)) {
+    }
+
+    std::shared_ptr<const std::string> text_; // слова query_ указывают сюда
+    Query query_;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "document.h"
+
+struct QueryCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    size_t size = 0;
+};
+
+// Кеш результатов запросов с вытеснением давно не использованных (LRU).
+// Записи помечены поколением индекса, на котором они посчитаны: после изменения
+// индекса поколение растёт, и старые записи считаются промахом и удаляются при
+// следующем обращении. Кеш разбит на независимые части со своими мьютексами,
+// так что параллельные запросы почти не ждут друг друга
+class QueryCache {
+public:
+    // capacity — сколько результатов хранить всего, с округлением вверх до числа частей
+    explicit QueryCache(size_t capacity);
+    // Копия — пустой кеш той же ёмкости: записи привязаны к поколениям исходного индекса
+    QueryCache(const QueryCache& other);
+    QueryCache& operator=(const QueryCache&) = delete;
+
+    std::optional<std::vector<Document>> Find(const std::string& key, uint64_t generation);
+    void Insert(const std::string& key, uint64_t generation, const std::vector<Document>& documents);
+
+    QueryCacheStats GetStats() const;
+
+private:
+    static constexpr size_t SHARD_COUNT = 16;
+
+    struct Entry {
+        std::string key;
+        uint64_t generation;
+        std::vector<Document> documents;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::list<Entry> entries; // в начале — последние использованные
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> positions; // ключи указывают в entries
+    };
+
+    Shard& GetShard(const std::string& key);
+
+    size_t shard_capacity_;
+    std::array<Shard, SHARD_COUNT> shards_;
+    std::atomic<uint64_t> hits_ = 0;
+    std::atomic<uint64_t> misses_ = 0;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "thread_pool.h"
+
+// Устойчивая поразрядная сортировка по 32-битному ключу key(item) в пуле потоков.
+// Проходов столько, сколько разрядов по RADIX_BITS бит занимает max_key.
+// Каждый проход: части массива параллельно считают гистограммы разрядов,
+// затем параллельно раскладывают элементы по своим непересекающимся позициям
+template <typename T, typename KeyFunc>
+void ParallelRadixSort(ThreadPool& pool, std::vector<T>& items, uint32_t max_key, KeyFunc key) {
+    static constexpr uint32_t RADIX_BITS = 11;
+    static constexpr size_t BUCKET_COUNT = size_t{ 1 } << RADIX_BITS;
+    // Меньшие части не окупают раздачу задач
+    static constexpr size_t MIN_ITEMS_PER_PART = 1 << 15;
+
+    const size_t part_count = std::max<size_t>(1, std::min(items.size() / MIN_ITEMS_PER_PART, pool.GetThreadCount() + 1));
+    auto part_begin = [&items, part_count](size_t part) {
+        return items.size() * part / part_count;
+    };
+    std::vector<T> buffer(items.size());
+    std::vector<size_t> positions(part_count * BUCKET_COUNT);
+
+    for (uint32_t shift = 0; shift < 32 && (max_key >> shift) > 0; shift += RADIX_BITS) {
+        std::fill(positions.begin(), positions.end(), 0);
+        pool.ParallelFor(part_count, [&](size_t part) {
+            size_t* counts = positions.data() + part * BUCKET_COUNT;
+            for (size_t i = part_begin(part); i < part_begin(part + 1); ++i) {
+                ++counts[(key(items[i]) >> shift) & (BUCKET_COUNT - 1)];
+            }
+        });
+        // Внутри разряда части идут по порядку, поэтому сортировка устойчива
+        size_t position = 0;
+        for (size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+            for (size_t part = 0; part < part_count; ++part) {
+                size_t& part_position = positions[part * BUCKET_COUNT + bucket];
+                const size_t count = part_position;
+                part_position = position;
+                position += count;
+            }
+        }
+        pool.ParallelFor(part_count, [&](size_t part) {
+            size_t* part_positions = positions.data() + part * BUCKET_COUNT;
+            for (size_t i = part_begin(part); i < part_begin(part + 1); ++i) {
+                buffer[part_positions[(key(items[i]) >> shift) & (BUCKET_COUNT - 1)]++] = items[i];
+            }
+        });
+        items.swap(buffer);
+    }
+}
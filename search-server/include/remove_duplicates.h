@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "search_server.h"
+
+// Дубликаты — документы с одинаковым множеством слов без стоп-слов; порядок
+// и число повторов слов не важны. Из группы дубликатов остаётся документ
+// с наименьшим id.
+//
+// Точный поиск сводит множество идентификаторов терминов каждого документа
+// к 128-битному отпечатку (в пуле потоков сервера) и находит совпадения за
+// один проход по документам в порядке id. Совпавшие отпечатки сверяются по
+// самим множествам, так что коллизия хеша не удалит документ.
+//
+// При min_jaccard < 1 ищутся почти-дубликаты: документы, у которых мера Жаккара
+// множеств слов |A ∩ B| / |A ∪ B| не меньше min_jaccard с каким-либо оставленным
+// документом с меньшим id. Кандидаты отбираются по MinHash-подписям, разбитым
+// на полосы (LSH): документы попадают в кандидаты, если совпала хотя бы одна
+// полоса целиком. Пара с мерой s становится кандидатом с вероятностью
+// 1 - (1 - s^rows_per_band)^band_count, поэтому поиск приближённый: изредка
+// пара выше порога пропускается, но лишнего не удаляется — каждый кандидат
+// проверяется точным подсчётом меры
+struct DuplicateSearchOptions {
+    double min_jaccard = 1.0;
+    size_t band_count = 20;
+    size_t rows_per_band = 5;
+    uint64_t seed = 0x9E3779B97F4A7C15;
+};
+
+// id документов, которые нужно удалить, по возрастанию
+std::vector<int> FindDuplicates(const SearchServer& search_server, const DuplicateSearchOptions& options = {});
+
+// Удаляет дубликаты одной пачкой и печатает id каждого удалённого документа
+void RemoveDuplicates(SearchServer& search_server, const DuplicateSearchOptions& options = {});
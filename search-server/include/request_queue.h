@@ -1,45 +1,60 @@
 #pragma once
  
+#include <chrono>
 #include <string>
 #include <vector>
-#include <deque>
  
+#include "request_stats.h"
 #include "search_server.h"
  
+// Выполняет запросы к серверу и ведёт их статистику за скользящее окно
+// реального времени, по умолчанию — сутки минутными корзинами. Методы можно
+// вызывать из нескольких потоков одновременно
 class RequestQueue {
 public:
+    static constexpr std::chrono::minutes DEFAULT_BUCKET_WIDTH{ 1 };
+    static constexpr size_t DEFAULT_BUCKET_COUNT = 1440;
  
-    explicit RequestQueue(const SearchServer& search_server);
+    explicit RequestQueue(const SearchServer& search_server,
+                          RequestStats::Clock::duration bucket_width = DEFAULT_BUCKET_WIDTH,
+                          size_t bucket_count = DEFAULT_BUCKET_COUNT);
  
     template <typename DocumentPredicate>
     std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate);
     std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentStatus status);
     std::vector<Document> AddFindRequest(const std::string& raw_query);
+
+    // Пакет запросов в пуле потоков сервера, как ProcessQueries; каждый запрос
+    // учитывается отдельно со своим временем выполнения
+    std::vector<std::vector<Document>> AddFindRequests(const std::vector<std::string>& raw_queries);
  
+    // Запросы без результатов за окно
     int GetNoResultRequests() const;
+    RequestWindowStats GetWindowStats() const;
+    RequestWindowStats GetTotalStats() const;
  
 private:
+
+    // Выполняет find() и учитывает его результат
+    template <typename Find>
+    std::vector<Document> Track(Find find);
  
-    std::deque<bool> requests_;
-    const static int sec_in_day_ = 1440;
     const SearchServer& search_server_;
-    int seconds = 0;
+    RequestStats stats_;
 }; 
  
 template <typename DocumentPredicate>
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate) {
- 
-    std::vector<Document> docs = search_server_.FindTopDocuments(raw_query, document_predicate);
- 
-    seconds++;
- 
-    while (seconds > sec_in_day_) {
-        requests_.pop_front();
-        seconds--;
-    }
- 
-    docs.empty() ? requests_.push_back(0) : requests_.push_back(1);
- 
-    return docs;
- 
+    return Track([&] {
+        return search_server_.FindTopDocuments(raw_query, document_predicate);
+    });
+}
+
+template <typename Find>
+std::vector<Document> RequestQueue::Track(Find find) {
+    const auto start = RequestStats::Clock::now();
+    std::vector<Document> documents = find();
+    const auto finish = RequestStats::Clock::now();
+    stats_.Record(finish, !documents.empty(), finish - start);
+    return documents;
 }
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Счётчики запросов за окно
+struct RequestWindowStats {
+    uint64_t request_count = 0;
+    uint64_t no_result_count = 0;
+    uint64_t latency_sum_ns = 0;
+
+    double GetMeanLatencyNs() const;
+    // Доля запросов без результатов, 0 при пустом окне
+    double GetNoResultShare() const;
+};
+
+// Статистика запросов в скользящем окне реального времени. Время steady_clock
+// делится на корзины по bucket_width, окно — последние bucket_count корзин,
+// включая текущую неполную. Корзины лежат в кольце, а суммы по окну хранятся
+// отдельно: запись прибавляет к своей корзине и к суммам, а корзина, выпадающая
+// из окна, вычитается из сумм, когда время до неё доходит. Поэтому и запись,
+// и чтение окна стоят O(1) (сдвиг окна — амортизированно), и всё это атомарные
+// операции, так что писать можно из любого числа потоков.
+//
+// Каждая ячейка кольца помечена эпохой, которой она отдана. Первый, кому ячейка
+// нужна для новой эпохи, — сдвиг окна или запись — помечает её занятой, вычитает
+// прежнее содержимое из сумм и только потом открывает ячейку новой эпохе; запись
+// той же эпохи ждёт этого. Поэтому очистка не забирает запросы новой эпохи.
+//
+// Запрос старше окна учитывается только в счётчиках за всё время. Проверка
+// возраста и прибавление к корзине не атомарны вместе: если между ними время
+// дошло до эпохи на bucket_count позже, ячейка кольца уже отдана этой эпохе, и
+// запрос попадает в неё, то есть остаётся в окне ещё на целое окно. Так бывает,
+// только если запрос записывают со временем, отстающим почти на всё окно. Суммы
+// окна при этом равны сумме корзин, так что ошибка не накапливается: каждый
+// запрос вычитается из окна ровно один раз, когда его ячейку отдают следующей эпохе
+class RequestStats {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    RequestStats(Clock::duration bucket_width, size_t bucket_count);
+
+    RequestStats(const RequestStats&) = delete;
+    RequestStats& operator=(const RequestStats&) = delete;
+
+    // time — когда запрос завершился
+    void Record(Clock::time_point time, bool has_results, Clock::duration latency);
+    void Record(bool has_results, Clock::duration latency) {
+        Record(Clock::now(), has_results, latency);
+    }
+
+    // Окно, оканчивающееся в now. Время не должно идти назад между вызовами
+    RequestWindowStats GetWindowStats(Clock::time_point now) const;
+    RequestWindowStats GetWindowStats() const {
+        return GetWindowStats(Clock::now());
+    }
+
+    RequestWindowStats GetTotalStats() const;
+
+    Clock::duration GetWindow() const {
+        return bucket_width_ * static_cast<Clock::rep>(bucket_count_);
+    }
+
+private:
+    struct Counters {
+        std::atomic<uint64_t> request_count = 0;
+        std::atomic<uint64_t> no_result_count = 0;
+        std::atomic<uint64_t> latency_sum_ns = 0;
+
+        void Add(bool has_results, uint64_t latency_ns);
+        RequestWindowStats Load() const;
+    };
+
+    // Ячейка кольца и эпоха, которой она отдана; пока старший бит поднят,
+    // прежнее содержимое ещё вычитается из сумм
+    struct Bucket {
+        static constexpr uint64_t CLAIMING = uint64_t{ 1 } << 63;
+
+        Counters counters;
+        std::atomic<uint64_t> epoch = 0;
+    };
+
+    uint64_t GetEpoch(Clock::time_point time) const;
+    // Сдвигает окно так, чтобы текущей была корзина epoch, вычитая выпавшие корзины из сумм
+    void Advance(uint64_t epoch) const;
+    // Отдаёт ячейку эпохе epoch, если она ещё принадлежит более ранней. false, если
+    // ячейка уже отдана более поздней эпохе
+    bool ClaimBucket(uint64_t epoch) const;
+
+    const Clock::time_point start_;
+    const Clock::duration bucket_width_;
+    const size_t bucket_count_;
+    // Корзина эпохи e — buckets_[e % bucket_count_]. Чтение тоже сдвигает окно,
+    // поэтому корзины и суммы изменяемы в константных методах
+    const std::unique_ptr<Bucket[]> buckets_;
+    mutable Counters window_;
+    mutable std::atomic<uint64_t> head_epoch_ = 0; // текущая корзина
+    Counters total_;
+};
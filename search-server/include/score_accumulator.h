@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Плоский массив релевантностей, индексированный порядковым номером документа.
+// Между запросами массив не очищается: значение считается заданным, только если
+// его метка совпадает с номером текущего запроса. Поэтому Reset стоит O(1),
+// а повторно используемый объект не выделяет память
+class ScoreAccumulator {
+public:
+    void Reset(size_t document_count) {
+        if (scores_.size() < document_count) {
+            scores_.resize(document_count);
+            score_epochs_.resize(document_count, 0);
+            filter_epochs_.resize(document_count, 0);
+        }
+        if (++epoch_ == 0) {
+            std::fill(score_epochs_.begin(), score_epochs_.end(), 0);
+            std::fill(filter_epochs_.begin(), filter_epochs_.end(), 0);
+            epoch_ = 1;
+        }
+        touched_.clear();
+        restricted_ = false;
+        mask_ = nullptr;
+    }
+
+    // Дополнительно принимаются только документы с единичным битом в mask
+    // (бит номера o — бит o % 64 слова o / 64). Карта должна жить до конца запроса
+    void SetMask(const std::vector<uint64_t>& mask) {
+        mask_ = mask.data();
+    }
+
+    // После Restrict принимаются только отмеченные документы, иначе —
+    // все, кроме исключённых через Exclude
+    void Restrict(const std::vector<int>& ordinals) {
+        restricted_ = true;
+        for (const int ordinal : ordinals) {
+            filter_epochs_[ordinal] = epoch_;
+        }
+    }
+
+    void Exclude(int ordinal) {
+        filter_epochs_[ordinal] = epoch_;
+    }
+
+    bool IsAccepted(int ordinal) const {
+        return (filter_epochs_[ordinal] == epoch_) == restricted_
+            && (mask_ == nullptr || ((mask_[ordinal / 64] >> (ordinal % 64)) & 1));
+    }
+
+    void Add(int ordinal, double value) {
+        Add(ordinal, value, touched_);
+    }
+
+    // Для параллельного счёта по непересекающимся диапазонам номеров:
+    // у каждого потока свой список затронутых документов
+    void Add(int ordinal, double value, std::vector<int>& touched) {
+        if (score_epochs_[ordinal] != epoch_) {
+            score_epochs_[ordinal] = epoch_;
+            scores_[ordinal] = 0.0;
+            touched.push_back(ordinal);
+        }
+        scores_[ordinal] += value;
+    }
+
+    double GetScore(int ordinal) const {
+        return scores_[ordinal];
+    }
+
+    // Дописывает списки потоков после параллельного счёта
+    void AppendTouched(const std::vector<int>& touched) {
+        touched_.insert(touched_.end(), touched.begin(), touched.end());
+    }
+
+    // Документы, получившие хотя бы одно слагаемое, в порядке первого касания
+    const std::vector<int>& GetTouched() const {
+        return touched_;
+    }
+
+private:
+    std::vector<double> scores_;
+    std::vector<uint32_t> score_epochs_;
+    std::vector<uint32_t> filter_epochs_;
+    std::vector<int> touched_;
+    uint32_t epoch_ = 0;
+    bool restricted_ = false;
+    const uint64_t* mask_ = nullptr;
+};
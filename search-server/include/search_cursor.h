@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "document.h"
+
+// Позиция в постраничной выдаче: ключ последнего отданного документа
+// (релевантность, рейтинг, id) и поколение индекса, на котором он посчитан.
+// Курсор по умолчанию указывает на начало выдачи
+class SearchCursor {
+public:
+    SearchCursor() = default;
+
+    bool IsStart() const {
+        return is_start_;
+    }
+
+    uint64_t GetGeneration() const {
+        return generation_;
+    }
+
+    // Шестнадцатеричная строка для передачи клиенту; у начала выдачи — пустая.
+    // FromString бросает std::invalid_argument, если строка не получена из ToString
+    std::string ToString() const;
+    static SearchCursor FromString(std::string_view text);
+
+private:
+    friend class SearchServer;
+
+    SearchCursor(const Document& last_document, uint64_t generation)
+        : is_start_(false)
+        , last_document_(last_document)
+        , generation_(generation) {
+    }
+
+    bool is_start_ = true;
+    Document last_document_;
+    uint64_t generation_ = 0;
+};
+
+struct SearchPage {
+    std::vector<Document> documents;
+    SearchCursor next;   // после последнего документа страницы
+    bool is_last = true; // дальше документов нет
+};
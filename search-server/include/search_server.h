@@ -1,94 +1,540 @@
 #pragma once
  
+#include <atomic>
+#include <climits>
+#include <limits>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
 #include <algorithm>
 #include <execution>
+#include <iterator>
  
 #include "document.h"
+#include "document_table.h"
+#include "flat_string_set.h"
+#include "index_format.h"
+#include "mapped_file.h"
+#include "metrics.h"
 #include "string_processing.h"
-#include "concurrent_map.h"
-const double DEVIATION = 1e-6;
+#include "posting_list.h"
+#include "query.h"
+#include "query_cache.h"
+#include "score_accumulator.h"
+#include "search_cursor.h"
+#include "sorted_set_ops.h"
+#include "term_dictionary.h"
+#include "thread_pool.h"
+#include "top_documents.h"
+
+class SearchServer;
+
+// Обход id документов сервера по возрастанию: сливает id, добавленные в память,
+// с id из файла индекса, пропуская удалённые. Действителен до изменения сервера
+class DocumentIdIterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = int;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const int*;
+    using reference = const int&;
+
+    DocumentIdIterator() = default;
+
+    reference operator*() const;
+    DocumentIdIterator& operator++();
+    DocumentIdIterator operator++(int);
+
+    bool operator==(const DocumentIdIterator& other) const {
+        return owned_ == other.owned_ && mapped_ == other.mapped_;
+    }
+
+    bool operator!=(const DocumentIdIterator& other) const {
+        return !(*this == other);
+    }
+
+private:
+    friend class SearchServer;
+
+    DocumentIdIterator(const SearchServer* server, std::set<int>::const_iterator owned, const IndexDocumentId* mapped);
+    void SkipRemoved();
+    bool IsOwnedNext() const;
+
+    const SearchServer* server_ = nullptr;
+    std::set<int>::const_iterator owned_;
+    const IndexDocumentId* mapped_ = nullptr;
+};
+
+// EXHAUSTIVE считает релевантность каждого документа из списков плюс-слов,
+// MAX_SCORE пропускает документы, которые по верхним границам TF * IDF
+// уже не могут попасть в выдачу. Вклады слов складываются в одном порядке,
+// так что релевантность совпадает побитно, а равные документы IsMoreRelevant
+// различает по id: выдача обоих режимов одна и та же. MAX_SCORE окупается, когда
+// граница вклада отдельного слова заметно ниже порога выдачи; если же
+// в топ выводят совпадения по одному-двум словам, дешевле полный перебор
+enum class RankingMode {
+    EXHAUSTIVE,
+    MAX_SCORE,
+};
+
+// PLAIN — исходный синтаксис: слова и минус-слова, '+' — обычный символ слова.
+// REQUIRED_TERMS добавляет обязательные слова: префикс '+' убирается, и документ
+// без такого слова в выдачу не попадает. Слово, которое само начинается с '+',
+// в этом режиме не найти, а "++x" и одинокий "+" — ошибка запроса
+enum class QuerySyntax {
+    PLAIN,
+    REQUIRED_TERMS,
+};
+
+// Документ для пакетного добавления. text нужен только на время AddDocuments
+struct NewDocument {
+    int id;
+    std::string_view text;
+    DocumentStatus status;
+    std::vector<int> ratings;
+};
+
+// Статистика всего корпуса для сервера, который служит одной из частей большего
+// индекса. IDF считается по ней, и релевантность документа не зависит от того,
+// в какой части он лежит
+class CorpusStatistics {
+public:
+    virtual ~CorpusStatistics() = default;
+
+    virtual int GetDocumentCount() const = 0;
+    // Число живых документов со словом
+    virtual uint32_t GetTermDocumentCount(std::string_view word) const = 0;
+    // Меняется при каждом изменении корпуса, в том числе самого сервера-части.
+    // Пока оно прежнее, сервер берёт IDF и результаты запросов из своих кешей
+    virtual uint64_t GetGeneration() const = 0;
+};
+
+// Статистика термина на текущем наборе документов
+struct TermStatistics {
+    uint32_t document_count;
+    double inverse_document_freq;
+    double max_term_freq; // верхняя граница TF по документам термина
+};
+
 class SearchServer {
 public:
  
     template <typename StringContainer>
     explicit SearchServer(const StringContainer& stop_words);
     explicit SearchServer(const std::string& stop_words_text);
+
+    // Открывает файл, записанный SaveIndex. Списки документов, строки терминов,
+    // списки терминов документов и id документов читаются прямо из отображённых
+    // страниц, в куче строится только таблица атрибутов. Бросает std::runtime_error,
+    // если файл повреждён или записан другой версией формата. По умолчанию
+    // проверяются заголовок, границы секций и записей, а содержимое списков
+    // считается доверенным, так что открытие не читает файл целиком. С verify
+    // сверяются контрольная сумма и всё содержимое — O(размера файла)
+    static SearchServer OpenIndex(const std::string& path, bool verify = false);
+
+    // Сохраняет индекс целиком: стоп-слова, словарь, списки документов,
+    // рейтинги и статусы, термины каждого документа. Существующий файл
+    // подменяется целиком, а серверы, уже открывшие его через OpenIndex, в том
+    // числе в других процессах, продолжают читать прежнее содержимое
+    void SaveIndex(const std::string& path) const;
  
     void AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+
+    // Добавляет пачку документов; индекс получается тем же, что и после AddDocument
+    // по очереди, включая идентификаторы терминов. Разбор текстов, назначение
+    // идентификаторов и построение списков идут в пуле потоков, списки строятся
+    // поразрядной сортировкой пар (термин, документ). Если какой-то документ
+    // некорректен, бросается std::invalid_argument и индекс не меняется
+    void AddDocuments(const std::vector<NewDocument>& documents);
  
+    // top_k — сколько лучших документов вернуть. document_predicate — функция
+    // (id, статус, рейтинг) либо StatusFilter или RatingRangeFilter: эти проверяются
+    // по битовым картам атрибутов, без вызова на каждый документ
     template <typename DocumentPredicate>
-std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate) const;
+std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate, size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
     template <typename DocumentPredicate, typename ExecutionPolicy>
-std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query, DocumentPredicate document_predicate) const;
+std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query, DocumentPredicate document_predicate, size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
  
-    std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentStatus status, size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
     template <class ExecutionPolicy>
-    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query, DocumentStatus status, size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
     
     std::vector<Document> FindTopDocuments(const std::string_view raw_query) const;
     template <class ExecutionPolicy>
     std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query) const;
+
+    // Разбирает запрос для многократного выполнения. Ошибки запроса — те же, что
+    // у FindTopDocuments, и бросаются здесь
+    PreparedQuery PrepareQuery(std::string_view raw_query) const;
+
+    std::vector<Document> FindTopDocuments(const PreparedQuery& query, DocumentStatus status = DocumentStatus::ACTUAL, size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
+    template <class ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const PreparedQuery& query, DocumentStatus status = DocumentStatus::ACTUAL, size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(const PreparedQuery& query, DocumentPredicate document_predicate, size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
+    template <typename DocumentPredicate, typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const PreparedQuery& query, DocumentPredicate document_predicate, size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
+ 
+    // Страница выдачи после документа, на котором остановился cursor; курсор по
+    // умолчанию — первая страница, следующий курсор — в SearchPage::next. Документы
+    // идут в порядке IsMoreRelevantStrict, так что страницы не пересекаются и не
+    // теряют документов. Счёт тот же, что у первой страницы, а отбор — куча на
+    // page_size + 1 документов, куда не попадают документы до курсора, поэтому
+    // страница N стоит как первая. Релевантность считается без отсечения MAX_SCORE
+    // и в кеш не попадает. Курсор годится для того же запроса и фильтра, пока набор
+    // документов не изменился; иначе бросается std::invalid_argument
+    SearchPage FindPage(const PreparedQuery& query, const SearchCursor& cursor, size_t page_size, DocumentStatus status = DocumentStatus::ACTUAL) const;
+    template <class ExecutionPolicy>
+    SearchPage FindPage(ExecutionPolicy&& policy, const PreparedQuery& query, const SearchCursor& cursor, size_t page_size, DocumentStatus status = DocumentStatus::ACTUAL) const;
+    template <typename DocumentPredicate>
+    SearchPage FindPage(const PreparedQuery& query, const SearchCursor& cursor, size_t page_size, DocumentPredicate document_predicate) const;
+    template <typename DocumentPredicate, typename ExecutionPolicy>
+    SearchPage FindPage(ExecutionPolicy&& policy, const PreparedQuery& query, const SearchCursor& cursor, size_t page_size, DocumentPredicate document_predicate) const;
  
     int GetDocumentCount() const;
+    uint32_t GetTermDocumentCount(std::string_view word) const;
+    // nullopt, если живых документов со словом нет
+    std::optional<TermStatistics> GetTermStatistics(std::string_view word) const;
+
+    // Статистика, по которой считается IDF; nullptr — собственные документы сервера.
+    // Объект должен пережить сервер
+    void SetCorpusStatistics(const CorpusStatistics* statistics);
+
+    // Дописывает в конец индекса живые документы source, для которых keep(document_id)
+    // истинно, в порядке их добавления в source. Тексты заново не разбираются:
+    // термины переназначаются по словарю, списки документов наращиваются с конца.
+    // Стоп-слова серверов должны совпадать. Если документ с таким id уже есть,
+    // бросает std::invalid_argument, не меняя индекс
+    template <typename DocumentFilter>
+    void MergeFrom(const SearchServer& source, DocumentFilter keep);
+
+    // Включает кеш результатов на capacity запросов, 0 — выключает. Ключ — разобранный
+    // запрос (плюс-, минус- и обязательные слова без стоп-слов), статус и top_k, так
+    // что запросы, отличающиеся порядком или повтором слов, делят запись. Кешируются
+    // только запросы с фильтром по статусу: с произвольным предикатом запрос всегда
+    // выполняется заново. Любое изменение набора документов, а при внешней
+    // статистике — любое изменение корпуса, делает прежние записи недействительными
+    void SetQueryCacheCapacity(size_t capacity);
+    // Разделители слов в документах и запросах; по умолчанию — пробел. Задаётся до
+    // добавления документов и в файл индекса не записывается
+    void SetTokenizerOptions(const TokenizerOptions& options);
+    QueryCacheStats GetQueryCacheStats() const;
+
+    // Режим ранжирования для последовательных запросов; параллельные всегда считают всё.
+    // Параллельный запрос делит диапазон номеров документов на части и считает их
+    // в общем пуле потоков; короткие запросы выполняются последовательно
+    void SetRankingMode(RankingMode mode);
+    RankingMode GetRankingMode() const;
+
+    // Синтаксис запросов, которые сервер разбирает дальше; уже подготовленные
+    // запросы не меняются. В файл индекса не записывается
+    void SetQuerySyntax(QuerySyntax syntax);
+    QuerySyntax GetQuerySyntax() const;
+
+    // Маска, в которой видны все живые документы, и скрытие документа в ней.
+    // HideDocument бросает std::out_of_range, если документа нет
+    DocumentMask MakeDocumentMask() const;
+    void HideDocument(DocumentMask& mask, int document_id) const;
+
+    // Пул для параллельных запросов, параллельного удаления и ProcessQueries.
+    // По умолчанию — ThreadPool::GetDefault(); пул должен пережить сервер
+    void SetThreadPool(ThreadPool& thread_pool);
+    ThreadPool& GetThreadPool() const;
  
-    std::set<int>::const_iterator begin() const;
-    std::set<int>::const_iterator end() const;
+    DocumentIdIterator begin() const;
+    DocumentIdIterator end() const;
     
     const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+
+    // Термины документа, отсортированные по TermId
+    struct DocumentTermRange {
+        const DocumentTerm* first;
+        const DocumentTerm* last;
+
+        const DocumentTerm* begin() const {
+            return first;
+        }
+
+        const DocumentTerm* end() const {
+            return last;
+        }
+
+        size_t size() const {
+            return last - first;
+        }
+    };
+
+    // Термины документа без построения словаря частот, как у GetWordFrequencies.
+    // Бросает std::out_of_range, если документа нет. Диапазон действителен до
+    // изменения индекса
+    DocumentTermRange GetDocumentTermRange(int document_id) const;
+    // Слово по идентификатору из DocumentTermRange. Строка лежит в словаре сервера
+    // и действительна, пока жив сервер
+    std::string_view GetTerm(TermId term_id) const;
     
+    // Удаление стоит O(числа терминов документа): документ помечается удалённым,
+    // а записи о нём остаются в списках, пока доля таких записей в списке не
+    // превысит порог. Тогда список перекодируется целиком, с параллельной
+    // политикой — в пуле потоков. Опустевшие списки освобождаются сразу.
+    // Порядковые номера удалённых документов освобождаются, когда их становится
+    // больше, чем живых: номера переназначаются подряд, и все списки с номерами
+    // после первого удалённого перекодируются. В среднем это те же O(числа
+    // терминов) на удаление. Маски MakeDocumentMask после этого устаревают
     void RemoveDocument(int document_id);
 
     template<class ExecutionPolicy>
     void RemoveDocument(ExecutionPolicy&& policy, int document_id);
+
+    // Удаляет пачку документов; каждый затронутый список сжимается не больше одного раза
+    void RemoveDocuments(const std::vector<int>& document_ids);
+
+    template<class ExecutionPolicy>
+    void RemoveDocuments(ExecutionPolicy&& policy, const std::vector<int>& document_ids);
+
+    // Вычищает все записи удалённых документов и освобождает их номера, не дожидаясь порогов
+    void CompactIndex();
  
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::string_view raw_query, int document_id) const;
     template<class ExecutionPolicy>
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(ExecutionPolicy&& policy, const std::string_view raw_query, int document_id) const;
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const PreparedQuery& query, int document_id) const;
+    template<class ExecutionPolicy>
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(ExecutionPolicy&& policy, const PreparedQuery& query, int document_id) const;
  
 private:
+    friend class DocumentIdIterator;
  
-    struct DocumentData {
-        int rating;
-        DocumentStatus status;
+    // IDF, посчитанный на поколении индекса generation. Пока индекс не меняется,
+    // его досчитывают параллельные запросы, и все пишут одно и то же значение:
+    // поэтому поля атомарные, а пара обновляется без блокировки
+    struct CachedInverseDocumentFreq {
+        static constexpr uint64_t NO_GENERATION = std::numeric_limits<uint64_t>::max();
+
+        std::atomic<uint64_t> generation = NO_GENERATION;
+        std::atomic<double> value = 0.0;
+
+        CachedInverseDocumentFreq() = default;
+        // Копируется только при росте таблицы, когда запросов нет
+        CachedInverseDocumentFreq(const CachedInverseDocumentFreq& other)
+            : generation(other.generation.load(std::memory_order_relaxed))
+            , value(other.value.load(std::memory_order_relaxed)) {
+        }
+    };
+
+    struct TermStats {
+        uint32_t document_count = 0; // живые документы, по ним считается IDF
+        uint32_t removed_count = 0;  // записи удалённых документов, ещё лежащие в списке
+        mutable CachedInverseDocumentFreq inverse_document_freq;
     };
+
+    SearchServer(std::shared_ptr<const MappedFile> index_file, bool verify);
+
     const std::set<std::string, std::less<>> stop_words_;
-    std::map<std::string, std::map<int, double>> word_to_document_freqs_; //да, он хранит исходный текст
-    std::map<int, std::map<std::string_view, double>> document_to_word_freqs_;
-    std::map<int, DocumentData> documents_;
+    const FlatStringSet stop_word_lookup_{ stop_words_ }; // для проверки слов текста
+    std::shared_ptr<const MappedFile> index_file_; // держит отображение, в которое указывают данные ниже
+    TermDictionary terms_;
+    std::vector<PostingList> term_postings_; // индекс — TermId, в списках порядковые номера документов
+    std::vector<TermStats> term_stats_; // индекс — TermId
+    // Термины документов из файла индекса; номера от mapped_document_count_ хранятся в owned_document_terms_
+    const IndexDocumentRecord* mapped_documents_ = nullptr;
+    const DocumentTerm* mapped_document_terms_ = nullptr;
+    int mapped_document_count_ = 0;
+    // id живых документов файла по возрастанию. Документы, добавленные после
+    // открытия, и все документы после RenumberDocuments лежат в document_ordinals_
+    const IndexDocumentId* mapped_document_ids_ = nullptr;
+    const IndexDocumentId* mapped_document_ids_end_ = nullptr;
+    int mapped_live_count_ = 0;
+    std::vector<std::vector<DocumentTerm>> owned_document_terms_;
+    // Частоты слов документов, построенные по запросу GetWordFrequencies; ключи
+    // указывают в terms_. Копия сервера получает пустой кеш со своим мьютексом,
+    // при перемещении частоты переезжают вместе со словарём
+    struct WordFrequencyCache {
+        std::map<int, std::map<std::string_view, double>> document_to_word_freqs;
+        std::mutex mutex;
+
+        WordFrequencyCache() = default;
+        WordFrequencyCache(const WordFrequencyCache&) {
+        }
+        WordFrequencyCache(WordFrequencyCache&& other) noexcept
+            : document_to_word_freqs(std::move(other.document_to_word_freqs)) {
+        }
+        WordFrequencyCache& operator=(const WordFrequencyCache&) {
+            document_to_word_freqs.clear();
+            return *this;
+        }
+        WordFrequencyCache& operator=(WordFrequencyCache&& other) noexcept {
+            document_to_word_freqs = std::move(other.document_to_word_freqs);
+            return *this;
+        }
+    };
+    mutable WordFrequencyCache word_freqs_cache_;
+    DocumentTable documents_; // индекс — порядковый номер; слоты удалённых документов освобождает RenumberDocuments
+    std::map<int, int> document_ordinals_; // без документов из mapped_document_ids_
     std::set<int> document_ids_;
+    RankingMode ranking_mode_ = RankingMode::EXHAUSTIVE;
+    QuerySyntax query_syntax_ = QuerySyntax::PLAIN;
+    ThreadPool* thread_pool_ = nullptr; // nullptr — общий пул
+    const CorpusStatistics* corpus_statistics_ = nullptr;
+    mutable std::optional<QueryCache> query_cache_; // копия сервера получает пустой кеш той же ёмкости
+    uint64_t generation_ = 0; // растёт при каждом изменении набора документов
+    Tokenizer tokenizer_;
  
+    // Поколение, на котором считаются IDF, кеш результатов и курсоры: своё или,
+    // при внешней статистике, поколение корпуса с поднятым старшим битом, чтобы
+    // они не совпадали
+    uint64_t GetStatisticsGeneration() const;
+
+    // Порядковый номер живого документа или -1
+    int FindOrdinal(int document_id) const;
+    // То же, но бросает std::out_of_range, если документа нет
+    int GetOrdinal(int document_id) const;
+    // Номер из файла проверяется при чтении: без verify файлу доверяют, но запись
+    // вне таблицы документов не должна выводить за её границы
+    bool IsLiveMappedId(const IndexDocumentId& entry) const {
+        return entry.ordinal >= 0 && entry.ordinal < mapped_document_count_ && !documents_.IsRemoved(entry.ordinal);
+    }
+
     bool IsStopWord(const std::string_view word) const;
  
     static bool IsValidWord(const std::string_view word);
  
-    std::vector<std::string_view> SplitIntoWordsNoStop(const std::string_view text) const;
+    // Заменяет содержимое words словами text без стоп-слов
+    void SplitIntoWordsNoStop(const std::string_view text, std::vector<std::string_view>& words) const;
  
     static int ComputeAverageRating(const std::vector<int>& ratings);
  
     struct QueryWord {
         std::string_view data;
         bool is_minus;
+        bool is_required;
         bool is_stop;
     };
  
-    QueryWord ParseQueryWord(const std::string_view text) const;
- 
-    struct Query {
-        std::set<std::string_view> plus_words;
-        std::set<std::string_view> minus_words;
-    };
+    QueryWord ParseQueryWord(const Token& token) const;
  
+    // Слова запроса лежат в небольших векторах на стеке, повторы убираются
+    // сортировкой, а идентификаторы слов находятся один раз на слово
     Query ParseQuery(const std::string_view text) const;
+    // Разбор без поиска слов в словаре
+    Query SplitQuery(const std::string_view text) const;
+    static std::string MakeQueryCacheKey(const Query& query, DocumentStatus status, size_t top_k);
+    // Совпадают ли идентификаторы слов запроса с идентификаторами этого словаря
+    bool IsQueryResolved(const Query& query) const;
+    void ResolveQuery(Query& query) const;
+    // Вызывает func(const Query&) с разобранным запросом, сверенным со словарём
+    template <typename Func>
+    auto WithResolvedQuery(const PreparedQuery& prepared, Func func) const;
+
+    // Фильтры из document_table.h проверяются картой в аккумуляторе, остальные
+    // предикаты — вызовом для каждого живого документа из списков плюс-слов
+    template <typename DocumentPredicate, typename ExecutionPolicy>
+    std::vector<Document> FindTopDocumentsForQuery(ExecutionPolicy&& policy, const Query& query, DocumentPredicate document_predicate, size_t top_k) const;
+    // Вызывает func(фильтр) с предикатом, которым ScoreOrdinalRange проверяет документы;
+    // для фильтров из document_table.h перед этим задаёт карту аккумулятора
+    template <typename DocumentPredicate, typename Func>
+    auto WithDocumentFilter(const Query& query, const DocumentPredicate& document_predicate, ScoreAccumulator& accumulator, Func func) const;
+    // Счёт и отбор по подготовленному аккумулятору
+    template <typename DocumentPredicate, typename ExecutionPolicy>
+    std::vector<Document> FindTopDocumentsScored(ExecutionPolicy&& policy, const Query& query, DocumentPredicate document_predicate,
+                                                 ScoreAccumulator& accumulator, size_t top_k) const;
+    // Поиск по статусу через кеш результатов, если он включён
+    template <class ExecutionPolicy>
+    std::vector<Document> FindTopDocumentsWithStatus(ExecutionPolicy&& policy, const Query& query, DocumentStatus status, size_t top_k) const;
+    template <typename DocumentPredicate, typename ExecutionPolicy>
+    SearchPage FindPageForQuery(ExecutionPolicy&& policy, const Query& query, DocumentPredicate document_predicate,
+                                const SearchCursor& cursor, size_t page_size) const;
+    // Релевантность всех подходящих документов, без отсечения. Слагаемые документа
+    // складываются в одном порядке при любой политике, поэтому значения совпадают до бита
+    template <typename DocumentPredicate, typename ExecutionPolicy>
+    void ScoreAllDocuments(ExecutionPolicy&& policy, const Query& query, DocumentPredicate& document_predicate, ScoreAccumulator& accumulator) const;
+    // Документы строго после курсора, не больше page_size
+    SearchPage SelectPage(const ScoreAccumulator& accumulator, const SearchCursor& cursor, size_t page_size) const;
+    template <class ExecutionPolicy>
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchQuery(ExecutionPolicy&& policy, const Query& query, int document_id) const;
  
-    double ComputeWordInverseDocumentFreq(const std::string_view word) const;
- 
+    double ComputeWordInverseDocumentFreq(TermId term_id) const;
+
+    DocumentTermRange GetDocumentTerms(int ordinal) const;
+    bool DocumentHasTerm(int document_id, TermId term_id) const;
+    // Помечает документ удалённым, обновляет статистику его терминов и дописывает
+    // их в removed_terms. Списки документов не трогает. false, если документа нет
+    bool MarkDocumentRemoved(int document_id, std::vector<TermId>& removed_terms);
+    // Сжимает списки терминов, где записей удалённых документов стало слишком много
+    template <typename ExecutionPolicy>
+    void CompactPostings(ExecutionPolicy&& policy, std::vector<TermId>& term_ids);
+    bool NeedsCompaction(TermId term_id) const;
+    void CompactPostingList(TermId term_id);
+    // Переназначает порядковые номера живым документам подряд, сохраняя их порядок
+    template <typename ExecutionPolicy>
+    void RenumberDocuments(ExecutionPolicy&& policy);
+    bool NeedsRenumbering() const;
+    // Новые номера по старым (-1 — удалённый документ) и термины, в чьих списках есть
+    // номера, которые сдвинутся или исчезнут
+    std::vector<int> PrepareRenumbering(std::vector<TermId>& term_ids) const;
+    // Перекодирует список в новые номера; таблица документов ещё должна быть старой
+    void RenumberPostingList(TermId term_id, const std::vector<int>& new_ordinals);
+    void RenumberDocumentTable(const std::vector<int>& new_ordinals);
+    // Переносит документы source с заданными порядковыми номерами, см. MergeFrom
+    void MergeOrdinalsFrom(const SearchServer& source, const std::vector<int>& source_ordinals);
+
+    struct WeightedTerm {
+        const PostingList* postings;
+        double inverse_document_freq;
+    };
+
+    // Непустые списки плюс-слов запроса вместе с их IDF
+    std::vector<WeightedTerm> ResolvePlusWords(const Query& query) const;
+    // Суммарная длина списков плюс-слов
+    size_t CountPlusPostings(const Query& query) const;
+
+    // Предикат-метка: всё уже проверено картой аккумулятора
+    struct MaskOnlyFilter {
+    };
+
+    // RatingRangeFilter без карты рейтинга: рейтинг берётся из столбца, статус
+    // и удаление — из карты, и обе проверки сливаются в одно условие
+    struct RatingWithBitmapFilter {
+        const RatingRangeFilter& filter;
+        const std::vector<uint64_t>& bitmap;
+    };
+
+    // Проверка документа, уже принятого аккумулятором
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const;
+    bool IsDocumentAccepted(DocumentPredicate& document_predicate, int ordinal) const;
+
+    static ScoreAccumulator& GetThreadAccumulator();
+
+    // Настраивает фильтр аккумулятора: при обязательных словах допускаются только
+    // документы из пересечения их списков за вычетом минус-слов, иначе исключаются
+    // документы минус-слов. Возвращает false, если подходящих документов нет
+    bool PrepareCandidateFilter(const Query& query, ScoreAccumulator& accumulator) const;
+    std::vector<Document> SelectTopDocuments(const ScoreAccumulator& accumulator, size_t top_k) const;
+    // На сколько частей делить параллельный счёт; меньше двух — считать последовательно
+    size_t CountScoringParts(const std::vector<WeightedTerm>& terms) const;
+
+    // Обход документов по возрастанию номеров с отсечением по MaxScore:
+    // плюс-слова упорядочены по верхней границе вклада, и слова, чья суммарная
+    // граница ниже порога выдачи, только досчитывают уже найденных кандидатов.
+    // Дополнительно проверяется граница TF в блоке, где лежал бы документ
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const std::execution::sequenced_policy&, const Query& query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopDocumentsPruned(const Query& query, DocumentPredicate document_predicate, const ScoreAccumulator& accumulator, size_t top_k) const;
+ 
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocumentsParallel(const Query& query, DocumentPredicate document_predicate, ScoreAccumulator& accumulator, size_t top_k) const;
+
+    // Считает вклад слов в документы с номерами из [ordinal_begin, ordinal_end)
+    // и передаёт его в add_score(ordinal, value)
+    template <typename DocumentPredicate, typename ScoreConsumer>
+    void ScoreOrdinalRange(const std::vector<WeightedTerm>& terms, DocumentPredicate& document_predicate, const ScoreAccumulator& accumulator,
+                           int ordinal_begin, int ordinal_end, ScoreConsumer add_score) const;
+
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const std::execution::parallel_policy&, const Query& query, DocumentPredicate document_predicate) const;
+    void FindAllDocuments(const Query& query, DocumentPredicate document_predicate, ScoreAccumulator& accumulator) const;
 };
  
 template <typename StringContainer>
@@ -100,38 +546,216 @@ SearchServer::SearchServer(const StringContainer& stop_words)
     }
 }
  
+template <typename DocumentFilter>
+void SearchServer::MergeFrom(const SearchServer& source, DocumentFilter keep) {
+    std::vector<int> source_ordinals;
+    for (int ordinal = 0; ordinal < static_cast<int>(source.documents_.size()); ++ordinal) {
+        if (!source.documents_.IsRemoved(ordinal) && keep(source.documents_.GetId(ordinal))) {
+            source_ordinals.push_back(ordinal);
+        }
+    }
+    MergeOrdinalsFrom(source, source_ordinals);
+}
+
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate) const {
-    return SearchServer::FindTopDocuments(std::execution::seq, raw_query, document_predicate);
+std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate, size_t top_k) const {
+    return SearchServer::FindTopDocuments(std::execution::seq, raw_query, document_predicate, top_k);
 }
 
 template <typename DocumentPredicate, typename ExecutionPolicy>
-std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query, DocumentPredicate document_predicate) const {
-    const auto query = ParseQuery(raw_query);
- 
-    auto matched_documents = FindAllDocuments(policy, query, document_predicate);
- 
-    sort(policy, matched_documents.begin(), matched_documents.end(), [](const Document& lhs, const Document& rhs) {
-        if (std::abs(lhs.relevance - rhs.relevance) < DEVIATION) {
-            return lhs.rating > rhs.rating;
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query, DocumentPredicate document_predicate, size_t top_k) const {
+    return FindTopDocumentsForQuery(policy, ParseQuery(raw_query), document_predicate, top_k);
+}
+
+template <typename DocumentPredicate, typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocumentsForQuery(ExecutionPolicy&& policy, const Query& query, DocumentPredicate document_predicate, size_t top_k) const {
+    ScoreAccumulator& accumulator = GetThreadAccumulator();
+    accumulator.Reset(documents_.size());
+    if (!PrepareCandidateFilter(query, accumulator)) {
+        return {};
+    }
+    return WithDocumentFilter(query, document_predicate, accumulator, [&](auto filter) {
+        return FindTopDocumentsScored(policy, query, filter, accumulator, top_k);
+    });
+}
+
+template <typename DocumentPredicate, typename Func>
+auto SearchServer::WithDocumentFilter(const Query& query, const DocumentPredicate& document_predicate, ScoreAccumulator& accumulator, Func func) const {
+    if constexpr (IS_MASKED_FILTER<DocumentPredicate>) {
+        const std::vector<uint64_t>& mask = document_predicate.mask.GetWords();
+        if (document_predicate.mask.visible_.size() != documents_.size()) {
+            throw std::invalid_argument("Document mask is out of date");
+        }
+        if constexpr (IS_BITMAP_FILTER<decltype(document_predicate.filter)>) {
+            static thread_local std::vector<uint64_t> filter_bitmap;
+            static thread_local std::vector<uint64_t> masked_bitmap;
+            const std::vector<uint64_t>& bitmap = document_predicate.filter.GetBitmap(documents_, filter_bitmap);
+            masked_bitmap.resize(bitmap.size());
+            for (size_t word = 0; word < bitmap.size(); ++word) {
+                masked_bitmap[word] = bitmap[word] & mask[word];
+            }
+            accumulator.SetMask(masked_bitmap);
+            return func(MaskOnlyFilter{});
         }
         else {
-            return lhs.relevance > rhs.relevance;
+            accumulator.SetMask(mask);
+            return func(document_predicate.filter);
+        }
+    }
+    else if constexpr (IS_BITMAP_FILTER<DocumentPredicate>) {
+        // Буфер для карты фильтра живёт до следующего запроса этого потока
+        static thread_local std::vector<uint64_t> filter_bitmap;
+        if constexpr (std::is_same_v<std::decay_t<DocumentPredicate>, RatingRangeFilter>) {
+            // Карта рейтинга читает весь столбец, и окупается, только если записей
+            // в списках плюс-слов не меньше, чем документов. Иначе дешевле
+            // проверить рейтинг у встреченных документов
+            if (CountPlusPostings(query) < documents_.size()) {
+                return func(RatingWithBitmapFilter{ document_predicate,
+                    document_predicate.status ? documents_.GetStatusBitmap(*document_predicate.status).GetWords()
+                                              : documents_.GetLiveBitmap().GetWords() });
+            }
         }
+        accumulator.SetMask(document_predicate.GetBitmap(documents_, filter_bitmap));
+        return func(MaskOnlyFilter{});
+    }
+    else {
+        return func(document_predicate);
+    }
+}
+
+template <typename DocumentPredicate, typename ExecutionPolicy>
+SearchPage SearchServer::FindPageForQuery(ExecutionPolicy&& policy, const Query& query, DocumentPredicate document_predicate,
+                                          const SearchCursor& cursor, size_t page_size) const {
+    if (page_size == 0) {
+        throw std::invalid_argument("Page size must be positive");
+    }
+    if (!cursor.IsStart() && cursor.GetGeneration() != GetStatisticsGeneration()) {
+        throw std::invalid_argument("Search cursor is stale: documents have changed");
+    }
+    ScoreAccumulator& accumulator = GetThreadAccumulator();
+    accumulator.Reset(documents_.size());
+    if (PrepareCandidateFilter(query, accumulator)) {
+        WithDocumentFilter(query, document_predicate, accumulator, [&](auto filter) {
+            METRICS_SCOPED_TIMER("query.scoring");
+            ScoreAllDocuments(policy, query, filter, accumulator);
         });
-    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
     }
- 
-    return matched_documents;
+    return SelectPage(accumulator, cursor, page_size);
+}
+
+template <typename DocumentPredicate, typename ExecutionPolicy>
+void SearchServer::ScoreAllDocuments([[maybe_unused]] ExecutionPolicy&& policy, const Query& query, DocumentPredicate& document_predicate, ScoreAccumulator& accumulator) const {
+    if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::parallel_policy>) {
+        const auto terms = ResolvePlusWords(query);
+        const size_t part_count = CountScoringParts(terms);
+        if (part_count >= 2) {
+            const int ordinal_count = static_cast<int>(documents_.size());
+            std::vector<std::vector<int>> part_touched(part_count);
+            GetThreadPool().ParallelFor(part_count, [&](size_t part) {
+                const int ordinal_begin = static_cast<int>(static_cast<int64_t>(ordinal_count) * part / part_count);
+                const int ordinal_end = static_cast<int>(static_cast<int64_t>(ordinal_count) * (part + 1) / part_count);
+                std::vector<int>& touched = part_touched[part];
+                ScoreOrdinalRange(terms, document_predicate, accumulator, ordinal_begin, ordinal_end,
+                    [&accumulator, &touched](int ordinal, double value) { accumulator.Add(ordinal, value, touched); });
+            });
+            for (const auto& touched : part_touched) {
+                accumulator.AppendTouched(touched);
+            }
+            return;
+        }
+    }
+    FindAllDocuments(query, document_predicate, accumulator);
+}
+
+template <typename DocumentPredicate, typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocumentsScored([[maybe_unused]] ExecutionPolicy&& policy, const Query& query, DocumentPredicate document_predicate,
+                                                           ScoreAccumulator& accumulator, size_t top_k) const {
+    // Параллельный поиск и MAX_SCORE отбирают лучшие документы по ходу счёта,
+    // поэтому отбор попадает в замер счёта целиком
+    if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::parallel_policy>) {
+        METRICS_SCOPED_TIMER("query.scoring");
+        return FindTopDocumentsParallel(query, document_predicate, accumulator, top_k);
+    }
+    else {
+        if (ranking_mode_ == RankingMode::MAX_SCORE) {
+            METRICS_SCOPED_TIMER("query.scoring");
+            return FindTopDocumentsPruned(query, document_predicate, accumulator, top_k);
+        }
+        {
+            METRICS_SCOPED_TIMER("query.scoring");
+            FindAllDocuments(query, document_predicate, accumulator);
+        }
+        return SelectTopDocuments(accumulator, top_k);
+    }
 }
 
 template <class ExecutionPolicy>
-std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(policy, raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-        return document_status == status;
-        });
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query, DocumentStatus status, size_t top_k) const {
+    return FindTopDocumentsWithStatus(policy, ParseQuery(raw_query), status, top_k);
+}
+
+template <class ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, const PreparedQuery& query, DocumentStatus status, size_t top_k) const {
+    return WithResolvedQuery(query, [&](const Query& resolved) {
+        return FindTopDocumentsWithStatus(policy, resolved, status, top_k);
+    });
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(const PreparedQuery& query, DocumentPredicate document_predicate, size_t top_k) const {
+    return FindTopDocuments(std::execution::seq, query, document_predicate, top_k);
+}
+
+template <typename DocumentPredicate, typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, const PreparedQuery& query, DocumentPredicate document_predicate, size_t top_k) const {
+    return WithResolvedQuery(query, [&](const Query& resolved) {
+        return FindTopDocumentsForQuery(policy, resolved, document_predicate, top_k);
+    });
+}
+
+template <class ExecutionPolicy>
+SearchPage SearchServer::FindPage(ExecutionPolicy&& policy, const PreparedQuery& query, const SearchCursor& cursor, size_t page_size, DocumentStatus status) const {
+    return FindPage(policy, query, cursor, page_size, StatusFilter{ status });
+}
+
+template <typename DocumentPredicate>
+SearchPage SearchServer::FindPage(const PreparedQuery& query, const SearchCursor& cursor, size_t page_size, DocumentPredicate document_predicate) const {
+    return FindPage(std::execution::seq, query, cursor, page_size, document_predicate);
+}
+
+template <typename DocumentPredicate, typename ExecutionPolicy>
+SearchPage SearchServer::FindPage(ExecutionPolicy&& policy, const PreparedQuery& query, const SearchCursor& cursor, size_t page_size, DocumentPredicate document_predicate) const {
+    return WithResolvedQuery(query, [&](const Query& resolved) {
+        return FindPageForQuery(policy, resolved, document_predicate, cursor, page_size);
+    });
+}
+
+template <typename Func>
+auto SearchServer::WithResolvedQuery(const PreparedQuery& prepared, Func func) const {
+    // Копия нужна, только если запрос разбирал другой сервер или словарь пополнился
+    if (IsQueryResolved(prepared.query_)) {
+        return func(prepared.query_);
+    }
+    Query query = prepared.query_;
+    ResolveQuery(query);
+    return func(query);
+}
+
+template <class ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocumentsWithStatus(ExecutionPolicy&& policy, const Query& query, DocumentStatus status, size_t top_k) const {
+    const StatusFilter status_predicate{ status };
+    if (!query_cache_) {
+        return FindTopDocumentsForQuery(policy, query, status_predicate, top_k);
+    }
+    const std::string key = MakeQueryCacheKey(query, status, top_k);
+    const uint64_t generation = GetStatisticsGeneration();
+    if (auto documents = query_cache_->Find(key, generation)) {
+        return std::move(*documents);
     }
+    auto documents = FindTopDocumentsForQuery(policy, query, status_predicate, top_k);
+    query_cache_->Insert(key, generation, documents);
+    return documents;
+}
 
 template <class ExecutionPolicy>
 std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query) const {
@@ -139,123 +763,303 @@ std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, c
 }
 
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const {
-    return SearchServer::FindAllDocuments(std::execution::seq, query, document_predicate);
-}
+std::vector<Document> SearchServer::FindTopDocumentsPruned(const Query& query, DocumentPredicate document_predicate, const ScoreAccumulator& accumulator, size_t top_k) const {
+    // Запас на погрешность округления при сложении границ
+    static constexpr double BOUND_SLACK = 1e-9;
+    if (top_k == 0) {
+        return {};
+    }
 
-template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const std::execution::sequenced_policy&, const Query& query, DocumentPredicate document_predicate) const {
-    std::map<int, double> document_to_relevance;
-
-    for_each (query.plus_words.begin(), query.plus_words.end(), 
-    [this, &document_predicate, &document_to_relevance] (const std::string_view& word) {
-        if (word_to_document_freqs_.count(std::string(word)) != 0) {
-            const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-            for (const auto [document_id, term_freq] : word_to_document_freqs_.at(std::string(word))) {
-                const auto& document_data = documents_.at(document_id);
-                if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                    document_to_relevance[document_id] += term_freq * inverse_document_freq;
-                }
-            }
+    struct TermCursor {
+        PostingList::Iterator it;
+        double inverse_document_freq;
+        double upper_bound;
+        size_t term_index; // позиция слова в запросе
+        int ordinal; // номер под итератором, INT_MAX в конце списка
+
+        void Sync() {
+            ordinal = it.IsEnd() ? INT_MAX : it->ordinal;
         }
+    };
+    std::vector<TermCursor> cursors;
+    for (const WeightedTerm& term : ResolvePlusWords(query)) {
+        cursors.push_back({ term.postings->begin(), term.inverse_document_freq,
+            term.postings->GetMaxTermFreq() * term.inverse_document_freq, cursors.size(), 0 });
+        cursors.back().Sync();
+    }
+    std::sort(cursors.begin(), cursors.end(), [](const TermCursor& lhs, const TermCursor& rhs) {
+        return lhs.upper_bound < rhs.upper_bound;
     });
+    // prefix_bounds[i] — сумма границ слов с 0 по i-е
+    std::vector<double> prefix_bounds(cursors.size());
+    for (size_t i = 0; i < cursors.size(); ++i) {
+        prefix_bounds[i] = cursors[i].upper_bound + (i > 0 ? prefix_bounds[i - 1] : 0.0);
+    }
+
+    TopDocuments top_documents(top_k);
+    auto cannot_enter = [&top_documents](double bound) {
+        return top_documents.IsFull() && bound + BOUND_SLACK <= top_documents.GetWorst().relevance - DEVIATION;
+    };
+    // Слова до first_essential не могут сами по себе вывести документ в топ
+    size_t first_essential = 0;
+    // Вклады слов кандидата по позициям в запросе. Релевантность складывается
+    // в порядке слов запроса, как при полном переборе, и совпадает с ним побитно;
+    // relevance ниже — частичная сумма только для сравнения с границами
+    std::vector<double> contributions(cursors.size());
+
+    while (first_essential < cursors.size()) {
+        int candidate = INT_MAX;
+        for (size_t i = first_essential; i < cursors.size(); ++i) {
+            candidate = std::min(candidate, cursors[i].ordinal);
+        }
+        if (candidate == INT_MAX) {
+            break;
+        }
 
-    for_each (query.minus_words.begin(), query.minus_words.end(),
-    [this, &document_to_relevance] (const std::string_view& word) {
-        if (word_to_document_freqs_.count(std::string(word)) != 0) {
-            for (const auto [document_id, _] : word_to_document_freqs_.at(std::string(word))) {
-                document_to_relevance.erase(document_id);
+        const double inv_word_count = documents_.GetInvWordCount(candidate);
+        double relevance = 0.0;
+        std::fill(contributions.begin(), contributions.end(), 0.0);
+        for (size_t i = first_essential; i < cursors.size(); ++i) {
+            TermCursor& cursor = cursors[i];
+            if (cursor.ordinal == candidate) {
+                const double contribution = cursor.it->term_count * inv_word_count * cursor.inverse_document_freq;
+                contributions[cursor.term_index] = contribution;
+                relevance += contribution;
+                ++cursor.it;
+                cursor.Sync();
             }
         }
-    });
-    
-    std::vector<Document> matched_documents;
-    for (const auto [document_id, relevance] : document_to_relevance) {
-        matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
+
+        if (!accumulator.IsAccepted(candidate)
+            || (first_essential > 0 && cannot_enter(relevance + prefix_bounds[first_essential - 1]))
+            || !IsDocumentAccepted(document_predicate, candidate)) {
+            continue;
+        }
+
+        bool pruned = false;
+        for (size_t i = first_essential; i > 0; --i) {
+            TermCursor& cursor = cursors[i - 1];
+            const double rest_bound = i > 1 ? prefix_bounds[i - 2] : 0.0;
+            const double block_bound = cursor.it.PeekBlockMaxTermFreq(candidate) * cursor.inverse_document_freq;
+            if (cannot_enter(relevance + block_bound + rest_bound)) {
+                pruned = true;
+                break;
+            }
+            if (cursor.ordinal < candidate) {
+                cursor.it.AdvanceTo(candidate);
+                cursor.Sync();
+            }
+            if (cursor.ordinal == candidate) {
+                const double contribution = cursor.it->term_count * inv_word_count * cursor.inverse_document_freq;
+                contributions[cursor.term_index] = contribution;
+                relevance += contribution;
+            }
+        }
+        if (pruned) {
+            continue;
+        }
+
+        // Нулевые вклады не меняют сумму, так что она та же, что у аккумулятора
+        double score = 0.0;
+        for (const double contribution : contributions) {
+            score += contribution;
+        }
+        top_documents.Push({ documents_.GetId(candidate), score, documents_.GetRating(candidate) });
+        while (first_essential < cursors.size() && cannot_enter(prefix_bounds[first_essential])) {
+            ++first_essential;
+        }
     }
-    
-    return matched_documents;
+
+    return top_documents.Extract();
 }
 
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const std::execution::parallel_policy&, const Query& query, DocumentPredicate document_predicate) const {
-    static constexpr int MINUS_LOCK_COUNT = 16;
-    ConcurrentMap<int, int> minus_ids(MINUS_LOCK_COUNT);
-    for_each(
-        std::execution::par,
-        query.minus_words.begin(),
-        query.minus_words.end(),
-        [this, &minus_ids](const std::string_view word) {
-            if (word_to_document_freqs_.count(std::string(word))) {
-                for (const auto& document_freqs : word_to_document_freqs_.at(std::string(word))) {
-                    minus_ids[document_freqs.first];
-                }
+std::vector<Document> SearchServer::FindTopDocumentsParallel(const Query& query, DocumentPredicate document_predicate, ScoreAccumulator& accumulator, size_t top_k) const {
+    const auto terms = ResolvePlusWords(query);
+    ThreadPool& pool = GetThreadPool();
+    const size_t part_count = CountScoringParts(terms);
+    const int ordinal_count = static_cast<int>(documents_.size());
+    if (part_count < 2) {
+        ScoreOrdinalRange(terms, document_predicate, accumulator, 0, ordinal_count,
+            [&accumulator](int ordinal, double value) { accumulator.Add(ordinal, value); });
+        return SelectTopDocuments(accumulator, top_k);
+    }
+
+    // Части не пересекаются по номерам документов, поэтому пишут в общий
+    // аккумулятор без блокировок, а списки затронутых документов у каждой свои
+    // thread_local в лямбде не захватывается: потоки пула видели бы свои копии
+    static thread_local std::vector<std::vector<int>> thread_part_touched;
+    std::vector<std::vector<int>>& part_touched = thread_part_touched;
+    part_touched.resize(std::max(part_touched.size(), part_count));
+    std::vector<std::vector<Document>> part_top_documents(part_count);
+    pool.ParallelFor(part_count, [&](size_t part) {
+        const int ordinal_begin = static_cast<int>(static_cast<int64_t>(ordinal_count) * part / part_count);
+        const int ordinal_end = static_cast<int>(static_cast<int64_t>(ordinal_count) * (part + 1) / part_count);
+        std::vector<int>& touched = part_touched[part];
+        touched.clear();
+        ScoreOrdinalRange(terms, document_predicate, accumulator, ordinal_begin, ordinal_end,
+            [&accumulator, &touched](int ordinal, double value) { accumulator.Add(ordinal, value, touched); });
+
+        TopDocuments top_documents(top_k);
+        for (const int ordinal : touched) {
+            top_documents.Push({ documents_.GetId(ordinal), accumulator.GetScore(ordinal), documents_.GetRating(ordinal) });
+        }
+        part_top_documents[part] = top_documents.Extract();
+    });
+
+    TopDocuments top_documents(top_k);
+    for (const auto& documents : part_top_documents) {
+        for (const Document& document : documents) {
+            top_documents.Push(document);
+        }
+    }
+    return top_documents.Extract();
+}
+
+template <typename DocumentPredicate, typename ScoreConsumer>
+void SearchServer::ScoreOrdinalRange(const std::vector<WeightedTerm>& terms, DocumentPredicate& document_predicate, const ScoreAccumulator& accumulator,
+                                     int ordinal_begin, int ordinal_end, ScoreConsumer add_score) const {
+    for (const WeightedTerm& term : terms) {
+        auto it = ordinal_begin == 0 ? term.postings->begin() : term.postings->LowerBound(ordinal_begin);
+        for (; !it.IsEnd() && it->ordinal < ordinal_end; ++it) {
+            const int ordinal = it->ordinal;
+            if (accumulator.IsAccepted(ordinal) && IsDocumentAccepted(document_predicate, ordinal)) {
+                add_score(ordinal, it->term_count * documents_.GetInvWordCount(ordinal) * term.inverse_document_freq);
             }
         }
-    );
+    }
+}
 
-    auto minus = minus_ids.BuildOrdinaryMap();
-    
-    static constexpr int PLUS_LOCK_COUNT = 10000;
-    ConcurrentMap<int, double> document_to_relevance(PLUS_LOCK_COUNT);
-    static constexpr int PART_COUNT = 16;
-    const auto part_length = query.plus_words.size() / PART_COUNT;
-    auto part_begin = query.plus_words.begin();
-    auto part_end = next(part_begin, part_length);
-    
-    std::vector<std::future<void>> futures;
-    for (int i = 0; 
-        i < PART_COUNT; 
-        ++i, part_begin = part_end, part_end = (i == PART_COUNT - 1 ? query.plus_words.end() : next(part_begin, part_length))
-        ) {
-        futures.push_back(std::async([this, part_begin, part_end, &document_predicate, &document_to_relevance, &minus] {
-            for_each(std::execution::par,
-                    part_begin, 
-                    part_end, 
-                    [this, &document_predicate, &document_to_relevance, &minus] (std::string_view word) {
-                    if (word_to_document_freqs_.count(std::string(word))) {
-                        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-                        for (const auto [document_id, term_freq] : word_to_document_freqs_.at(std::string(word))) {
-                            const auto& document_data = documents_.at(document_id);
-                            if (document_predicate(document_id, document_data.status, document_data.rating) && (minus.count(document_id) == 0)) {
-                                document_to_relevance[document_id].ref_to_value += term_freq * inverse_document_freq;
-                            }
-                        }
-                    }
-            });
-        }));
+template <typename DocumentPredicate>
+bool SearchServer::IsDocumentAccepted(DocumentPredicate& document_predicate, int ordinal) const {
+    if constexpr (std::is_same_v<DocumentPredicate, MaskOnlyFilter>) {
+        return true;
     }
-    
-    for (auto& stage : futures) {
-        stage.get();
+    else if constexpr (std::is_same_v<DocumentPredicate, RatingWithBitmapFilter>) {
+        const bool in_bitmap = (document_predicate.bitmap[ordinal / 64] >> (ordinal % 64)) & 1;
+        return in_bitmap & document_predicate.filter.IsRatingAccepted(documents_.GetRating(ordinal));
     }
-    
-    std::vector<Document> matched_documents;
-    for (const auto [document_id, relevance] : document_to_relevance.BuildOrdinaryMap()) {
-        matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
+    else {
+        return !documents_.IsRemoved(ordinal)
+            && document_predicate(documents_.GetId(ordinal), documents_.GetStatus(ordinal), documents_.GetRating(ordinal));
     }
-    return matched_documents;
+}
+
+template <typename DocumentPredicate>
+void SearchServer::FindAllDocuments(const Query& query, DocumentPredicate document_predicate, ScoreAccumulator& accumulator) const {
+    ScoreOrdinalRange(ResolvePlusWords(query), document_predicate, accumulator, 0, static_cast<int>(documents_.size()),
+        [&accumulator](int ordinal, double value) { accumulator.Add(ordinal, value); });
 }
 
 template<class ExecutionPolicy>
 void SearchServer::RemoveDocument(ExecutionPolicy&& policy, int document_id){
-	auto it = document_ids_.find(document_id);
-	if (it == document_ids_.end()) {
-		return;
-	}
-	
-	auto& items = document_to_word_freqs_.at(document_id);
-	
-	std::vector<const std::string*> words(items.size());
-	std::transform(policy, items.begin(), items.end(), words.begin(), [](auto& p) { return &p.first; });
-	
-	std::for_each(policy, words.begin(), words.end(),
-		[&](auto word) {
-			word_to_document_freqs_.at(*word).erase(document_id);
-		}
-	);
-
-	document_ids_.erase(document_id);
-	documents_.erase(document_id);
-	document_to_word_freqs_.erase(document_id);
+    METRICS_SCOPED_TIMER("index.remove_document");
+    std::vector<TermId> removed_terms;
+    if (MarkDocumentRemoved(document_id, removed_terms)) {
+        METRICS_COUNTER_ADD("index.documents_removed", 1);
+        if (NeedsRenumbering()) {
+            RenumberDocuments(policy);
+        }
+        else {
+            CompactPostings(policy, removed_terms);
+        }
+    }
+}
+
+template<class ExecutionPolicy>
+void SearchServer::RemoveDocuments(ExecutionPolicy&& policy, const std::vector<int>& document_ids) {
+    METRICS_SCOPED_TIMER("index.remove_documents");
+    std::vector<TermId> removed_terms;
+    for (const int document_id : document_ids) {
+        if (MarkDocumentRemoved(document_id, removed_terms)) {
+            METRICS_COUNTER_ADD("index.documents_removed", 1);
+        }
+    }
+    if (NeedsRenumbering()) {
+        RenumberDocuments(policy);
+        return;
+    }
+    std::sort(removed_terms.begin(), removed_terms.end());
+    removed_terms.erase(std::unique(removed_terms.begin(), removed_terms.end()), removed_terms.end());
+    CompactPostings(policy, removed_terms);
+}
+
+template <typename ExecutionPolicy>
+void SearchServer::CompactPostings([[maybe_unused]] ExecutionPolicy&& policy, std::vector<TermId>& term_ids) {
+    term_ids.erase(std::remove_if(term_ids.begin(), term_ids.end(), [this](TermId term_id) {
+        return !NeedsCompaction(term_id);
+    }), term_ids.end());
+    // Разные списки сжимаются независимо
+    if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::parallel_policy>) {
+        GetThreadPool().ParallelFor(term_ids.size(), [&](size_t i) {
+            CompactPostingList(term_ids[i]);
+        });
+    }
+    else {
+        for (const TermId term_id : term_ids) {
+            CompactPostingList(term_id);
+        }
+    }
+}
+
+template <typename ExecutionPolicy>
+void SearchServer::RenumberDocuments([[maybe_unused]] ExecutionPolicy&& policy) {
+    METRICS_SCOPED_TIMER("index.renumber_documents");
+    std::vector<TermId> term_ids;
+    const std::vector<int> new_ordinals = PrepareRenumbering(term_ids);
+    if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::parallel_policy>) {
+        GetThreadPool().ParallelFor(term_ids.size(), [&](size_t i) {
+            RenumberPostingList(term_ids[i], new_ordinals);
+        });
+    }
+    else {
+        for (const TermId term_id : term_ids) {
+            RenumberPostingList(term_id, new_ordinals);
+        }
+    }
+    RenumberDocumentTable(new_ordinals);
+}
+
+template<class ExecutionPolicy>
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(ExecutionPolicy&& policy, const std::string_view raw_query, int document_id) const {
+    if (FindOrdinal(document_id) < 0) {
+        throw std::out_of_range("Такой id не существует");
+    }
+    return MatchQuery(policy, ParseQuery(raw_query), document_id);
+}
+
+template<class ExecutionPolicy>
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(ExecutionPolicy&& policy, const PreparedQuery& query, int document_id) const {
+    if (FindOrdinal(document_id) < 0) {
+        throw std::out_of_range("Такой id не существует");
+    }
+    return WithResolvedQuery(query, [&](const Query& resolved) {
+        return MatchQuery(policy, resolved, document_id);
+    });
+}
+
+template<class ExecutionPolicy>
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchQuery(ExecutionPolicy&& policy, const Query& query, int document_id) const {
+	std::vector<std::string_view> matched_words;
+
+    if (std::any_of(policy, //с seq в первый раз, скорость от чего то быстрее была, сейчс не заметно
+                query.minus_terms.begin(),
+                query.minus_terms.end(),
+                [&](const QueryTerm& term) { return DocumentHasTerm(document_id, term.term_id); }
+               )
+        || !std::all_of(policy,
+                query.required_terms.begin(),
+                query.required_terms.end(),
+                [&](const QueryTerm& term) { return DocumentHasTerm(document_id, term.term_id); }
+               )) {
+        return { matched_words, documents_.GetStatus(GetOrdinal(document_id)) };
+    }
+    // Слова отдаются из словаря, а не из текста запроса: вызывающий может сразу освободить запрос
+    for (const QueryTerm& term : query.plus_terms) {
+        if (DocumentHasTerm(document_id, term.term_id)) {
+            matched_words.push_back(terms_.GetTerm(term.term_id));
+        }
+    }
+
+	return { matched_words, documents_.GetStatus(GetOrdinal(document_id)) };
 }
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cstdint>
+#include <execution>
+#include <future>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "document.h"
+#include "search_server.h"
+#include "top_documents.h"
+
+struct SegmentPolicy {
+    // Сколько документов копится в изменяемом сегменте, прежде чем он запечатывается
+    size_t max_mutable_documents = 1 << 16;
+    // Сколько запечатанных сегментов допускается до запуска слияния
+    size_t max_segment_count = 8;
+    // Сколько самых маленьких сегментов сливается за раз
+    size_t merge_factor = 4;
+    // Если задан, результаты слияний записываются сюда через SaveIndex и
+    // читаются прямо из отображённых файлов. Каждый сегмент получает файл с
+    // новым именем, так что каталог могут делить несколько серверов; файл
+    // удаляется вместе с сегментом
+    std::string directory;
+};
+
+// Индекс из небольшого изменяемого сегмента и набора неизменяемых. Новые документы
+// попадают в изменяемый сегмент; заполнившись, он запечатывается. Удаление из
+// запечатанного сегмента только ставит бит в его битовой карте. Когда запечатанных
+// сегментов становится больше max_segment_count, самые маленькие сливаются в
+// фоновом потоке в один сегмент без удалённых документов, а результат
+// подключается при следующем изменении индекса.
+// Запрос выполняется в каждом сегменте, IDF считается по всему корпусу, лучшие
+// документы сегментов сливаются в общий топ. Как и SearchServer, константные
+// методы можно вызывать одновременно, а изменяющие — только в одиночку
+class SegmentedSearchServer : public CorpusStatistics {
+public:
+    template <typename StringContainer>
+    explicit SegmentedSearchServer(const StringContainer& stop_words, SegmentPolicy policy = {});
+    explicit SegmentedSearchServer(const std::string& stop_words_text, SegmentPolicy policy = {});
+
+    SegmentedSearchServer(const SegmentedSearchServer&) = delete;
+    SegmentedSearchServer& operator=(const SegmentedSearchServer&) = delete;
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    void RemoveDocument(int document_id);
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate, size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
+    // С параллельной политикой сегменты опрашиваются в пуле потоков
+    template <typename DocumentPredicate, typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate, size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status, size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
+
+    int GetDocumentCount() const override;
+    uint32_t GetTermDocumentCount(std::string_view word) const override;
+    uint64_t GetGeneration() const override;
+
+    std::set<int>::const_iterator begin() const;
+    std::set<int>::const_iterator end() const;
+
+    // Число запечатанных сегментов
+    size_t GetSegmentCount() const;
+
+    // Запечатывает изменяемый сегмент, не дожидаясь его заполнения
+    void Flush();
+    // Дожидается идущего слияния и подключает его результат
+    void WaitForMerges();
+
+    void SetRankingMode(RankingMode mode);
+    void SetQuerySyntax(QuerySyntax syntax);
+
+private:
+    struct Segment {
+        SearchServer index;
+        std::vector<int> document_ids; // по возрастанию
+        std::vector<bool> is_deleted;  // индекс — позиция в document_ids
+        size_t deleted_count = 0;
+        // Те же удаления по порядковым номерам index: запросы применяют их картой аккумулятора
+        DocumentMask visible;
+        // Удалённые документы каждого слова, вычитаются из статистики index. Ключи
+        // указывают в словарь index
+        std::unordered_map<std::string_view, uint32_t> deleted_term_counts;
+        std::string path; // файл сегмента, если он отображён
+
+        explicit Segment(SearchServer&& index);
+        ~Segment();
+
+        bool IsDeleted(int document_id) const;
+    };
+
+    struct PendingMerge {
+        std::vector<std::shared_ptr<Segment>> inputs;
+        // Битовые карты входов на момент начала слияния
+        std::vector<std::vector<bool>> deleted_snapshots;
+        // Последним: при разрушении сначала дожидается слияния, читающего поля выше
+        std::future<std::shared_ptr<Segment>> result;
+    };
+
+    // Без directory сегмент держит index в памяти, иначе записывает его в новый файл каталога
+    static std::shared_ptr<Segment> MakeSegment(SearchServer&& index, const std::string& directory);
+    static std::shared_ptr<Segment> MergeSegments(const std::set<std::string, std::less<>>& stop_words,
+                                                  const std::vector<std::shared_ptr<Segment>>& inputs,
+                                                  const std::vector<std::vector<bool>>& deleted_snapshots,
+                                                  const std::string& directory);
+
+    void ResetMutableSegment();
+    void MarkDeleted(Segment& segment, int document_id);
+    void SealMutableSegment();
+    // Подключает результат слияния, если он готов (или дождавшись его, если wait)
+    void InstallMerge(bool wait);
+    void ScheduleMerge();
+
+    const std::set<std::string, std::less<>> stop_words_;
+    const SegmentPolicy policy_;
+    RankingMode ranking_mode_ = RankingMode::EXHAUSTIVE;
+    QuerySyntax query_syntax_ = QuerySyntax::PLAIN; // запросы разбирает изменяемый сегмент
+    std::optional<SearchServer> mutable_segment_;
+    std::vector<std::shared_ptr<Segment>> segments_;
+    std::set<int> document_ids_;
+    uint64_t generation_ = 0; // растёт при каждом изменении набора документов
+    std::optional<PendingMerge> pending_merge_; // последним: слияние читает сегменты и стоп-слова
+};
+
+template <typename StringContainer>
+SegmentedSearchServer::SegmentedSearchServer(const StringContainer& stop_words, SegmentPolicy policy)
+    : stop_words_(MakeUniqueNonEmptyStrings(stop_words))
+    , policy_(std::move(policy)) {
+    ResetMutableSegment();
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate, size_t top_k) const {
+    return FindTopDocuments(std::execution::seq, raw_query, document_predicate, top_k);
+}
+
+template <typename DocumentPredicate, typename ExecutionPolicy>
+std::vector<Document> SegmentedSearchServer::FindTopDocuments([[maybe_unused]] ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate, size_t top_k) const {
+    // Запрос разбирается один раз; стоп-слова и разделители у сегментов общие.
+    // Последняя часть — изменяемый сегмент
+    const PreparedQuery query = mutable_segment_->PrepareQuery(raw_query);
+    std::vector<std::vector<Document>> results(segments_.size() + 1);
+    auto search_segment = [&](size_t i) {
+        if (i == segments_.size()) {
+            results[i] = mutable_segment_->FindTopDocuments(query, document_predicate, top_k);
+            return;
+        }
+        const Segment& segment = *segments_[i];
+        if (segment.deleted_count == 0) {
+            results[i] = segment.index.FindTopDocuments(query, document_predicate, top_k);
+        }
+        else {
+            results[i] = segment.index.FindTopDocuments(query,
+                MaskedFilter<DocumentPredicate>{ segment.visible, document_predicate }, top_k);
+        }
+    };
+    if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::parallel_policy>) {
+        mutable_segment_->GetThreadPool().ParallelFor(results.size(), search_segment);
+    }
+    else {
+        for (size_t i = 0; i < results.size(); ++i) {
+            search_segment(i);
+        }
+    }
+
+    TopDocuments top_documents(top_k);
+    for (const auto& documents : results) {
+        for (const Document& document : documents) {
+            top_documents.Push(document);
+        }
+    }
+    return top_documents.Extract();
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <execution>
+#include <functional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "document.h"
+#include "search_server.h"
+#include "top_documents.h"
+
+struct ShardingOptions {
+    size_t shard_count = 4;
+    // Пусто — документы раскладываются по хешу id. Иначе — по диапазонам id:
+    // shard_count - 1 возрастающих границ, шард i получает id из
+    // [range_bounds[i - 1], range_bounds[i]), крайние шарды — всё, что снаружи
+    std::vector<int> range_bounds;
+};
+
+// Индекс из нескольких независимых SearchServer — шардов. Шард документа определяется
+// его id, так что добавление, удаление и MatchDocument обращаются к одному шарду,
+// а пакетное добавление и пакетное удаление с параллельной политикой идут во всех
+// шардах одновременно. Запрос разбирается один раз и выполняется в каждом шарде,
+// лучшие документы шардов сливаются в общий топ. IDF считается по всему корпусу,
+// поэтому релевантность документов та же, что в одном нешардированном индексе;
+// шарды кешируют IDF, пока не изменится поколение корпуса.
+// Как и SearchServer, константные методы можно вызывать одновременно, а изменяющие —
+// только в одиночку
+class ShardedSearchServer : public CorpusStatistics {
+public:
+    template <typename StringContainer>
+    explicit ShardedSearchServer(const StringContainer& stop_words, ShardingOptions options = {});
+    explicit ShardedSearchServer(const std::string& stop_words_text, ShardingOptions options = {});
+
+    ShardedSearchServer(const ShardedSearchServer&) = delete;
+    ShardedSearchServer& operator=(const ShardedSearchServer&) = delete;
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    // Документы раскладываются по шардам и добавляются в каждый через SearchServer::AddDocuments.
+    // Если какой-то документ некорректен, бросается std::invalid_argument, а уже
+    // добавленные документы пачки удаляются, так что набор документов не меняется
+    void AddDocuments(const std::vector<NewDocument>& documents);
+
+    void RemoveDocument(int document_id);
+    template <class ExecutionPolicy>
+    void RemoveDocument(ExecutionPolicy&& policy, int document_id);
+    void RemoveDocuments(const std::vector<int>& document_ids);
+    // С параллельной политикой шарды удаляют свои части одновременно и сжимают
+    // списки в пуле потоков
+    template <class ExecutionPolicy>
+    void RemoveDocuments(ExecutionPolicy&& policy, const std::vector<int>& document_ids);
+
+    PreparedQuery PrepareQuery(std::string_view raw_query) const;
+
+    // Без политики, как и с последовательной, шарды опрашиваются по очереди.
+    // С параллельной — в пуле потоков, и каждый считает запрос последовательно
+    // в своём режиме ранжирования
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate, size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
+    template <typename DocumentPredicate, typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate, size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status, size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
+    template <class ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status, size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+    template <class ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const;
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(const PreparedQuery& query, DocumentPredicate document_predicate, size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
+    template <typename DocumentPredicate, typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const PreparedQuery& query, DocumentPredicate document_predicate, size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
+    std::vector<Document> FindTopDocuments(const PreparedQuery& query, DocumentStatus status = DocumentStatus::ACTUAL, size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
+
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
+    template <class ExecutionPolicy>
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(ExecutionPolicy&& policy, std::string_view raw_query, int document_id) const;
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const PreparedQuery& query, int document_id) const;
+    template <class ExecutionPolicy>
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(ExecutionPolicy&& policy, const PreparedQuery& query, int document_id) const;
+
+    int GetDocumentCount() const override;
+    uint32_t GetTermDocumentCount(std::string_view word) const override;
+    uint64_t GetGeneration() const override;
+
+    size_t GetShardCount() const;
+    // Номер шарда, в котором лежит или окажется документ
+    size_t GetShardIndex(int document_id) const;
+    const SearchServer& GetShard(size_t shard_index) const;
+
+    void SetRankingMode(RankingMode mode);
+    void SetQuerySyntax(QuerySyntax syntax);
+    // Пул для опроса шардов и для их собственных параллельных операций
+    void SetThreadPool(ThreadPool& thread_pool);
+    ThreadPool& GetThreadPool() const;
+
+private:
+    void InitShards(const std::set<std::string, std::less<>>& stop_words);
+    // Раскладывает id по шардам, сохраняя их порядок
+    std::vector<std::vector<int>> SplitByShard(const std::vector<int>& document_ids) const;
+
+    const ShardingOptions options_;
+    std::vector<SearchServer> shards_; // не перемещаются: каждый хранит указатель на this
+    uint64_t generation_ = 0; // растёт при каждом изменении набора документов
+};
+
+template <typename StringContainer>
+ShardedSearchServer::ShardedSearchServer(const StringContainer& stop_words, ShardingOptions options)
+    : options_(std::move(options)) {
+    InitShards(MakeUniqueNonEmptyStrings(stop_words));
+}
+
+template <class ExecutionPolicy>
+void ShardedSearchServer::RemoveDocument(ExecutionPolicy&& policy, int document_id) {
+    ++generation_;
+    shards_[GetShardIndex(document_id)].RemoveDocument(policy, document_id);
+}
+
+template <class ExecutionPolicy>
+void ShardedSearchServer::RemoveDocuments(ExecutionPolicy&& policy, const std::vector<int>& document_ids) {
+    ++generation_;
+    const std::vector<std::vector<int>> parts = SplitByShard(document_ids);
+    auto remove_part = [&](size_t i) {
+        if (!parts[i].empty()) {
+            shards_[i].RemoveDocuments(policy, parts[i]);
+        }
+    };
+    if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::parallel_policy>) {
+        GetThreadPool().ParallelFor(shards_.size(), remove_part);
+    }
+    else {
+        for (size_t i = 0; i < shards_.size(); ++i) {
+            remove_part(i);
+        }
+    }
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate, size_t top_k) const {
+    return FindTopDocuments(std::execution::seq, raw_query, document_predicate, top_k);
+}
+
+template <typename DocumentPredicate, typename ExecutionPolicy>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate, size_t top_k) const {
+    // Стоп-слова и разделители у шардов общие, так что запрос разбирается один раз
+    return FindTopDocuments(policy, PrepareQuery(raw_query), document_predicate, top_k);
+}
+
+template <class ExecutionPolicy>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status, size_t top_k) const {
+    // Статус передаётся шардам как есть, чтобы они отбирали документы по битовым картам
+    return FindTopDocuments(policy, PrepareQuery(raw_query), status, top_k);
+}
+
+template <class ExecutionPolicy>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const {
+    return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(const PreparedQuery& query, DocumentPredicate document_predicate, size_t top_k) const {
+    return FindTopDocuments(std::execution::seq, query, document_predicate, top_k);
+}
+
+template <typename DocumentPredicate, typename ExecutionPolicy>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(ExecutionPolicy&& policy, const PreparedQuery& query, DocumentPredicate document_predicate, size_t top_k) const {
+    // Общий топ-k содержится в объединении топ-k шардов
+    std::vector<std::vector<Document>> results(shards_.size());
+    if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::parallel_policy>) {
+        // Параллельность — по шардам, внутри шарда запрос считается последовательно
+        GetThreadPool().ParallelFor(results.size(), [&](size_t i) {
+            results[i] = shards_[i].FindTopDocuments(query, document_predicate, top_k);
+        });
+    }
+    else {
+        for (size_t i = 0; i < results.size(); ++i) {
+            results[i] = shards_[i].FindTopDocuments(policy, query, document_predicate, top_k);
+        }
+    }
+
+    TopDocuments top_documents(top_k);
+    for (const auto& documents : results) {
+        for (const Document& document : documents) {
+            top_documents.Push(document);
+        }
+    }
+    return top_documents.Extract();
+}
+
+template <class ExecutionPolicy>
+std::tuple<std::vector<std::string_view>, DocumentStatus> ShardedSearchServer::MatchDocument(ExecutionPolicy&& policy, std::string_view raw_query, int document_id) const {
+    return shards_[GetShardIndex(document_id)].MatchDocument(policy, raw_query, document_id);
+}
+
+template <class ExecutionPolicy>
+std::tuple<std::vector<std::string_view>, DocumentStatus> ShardedSearchServer::MatchDocument(ExecutionPolicy&& policy, const PreparedQuery& query, int document_id) const {
+    return shards_[GetShardIndex(document_id)].MatchDocument(policy, query, document_id);
+}
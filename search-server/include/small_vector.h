@@ -0,0 +1,155 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+// Вектор, первые N элементов которого лежат в самом объекте. Пока элементов
+// не больше N, память не выделяется; дальше они переезжают в кучу, как у
+// std::vector. Только для тривиально копируемых типов: элементы переносятся
+// копированием байтов, а конструкторы и деструкторы не вызываются
+template <typename T, size_t N>
+class SmallVector {
+    static_assert(std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>,
+                  "SmallVector stores only trivially copyable types");
+
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    SmallVector() = default;
+
+    SmallVector(const SmallVector& other) {
+        Append(other.begin(), other.end());
+    }
+
+    SmallVector(SmallVector&& other) noexcept {
+        MoveFrom(other);
+    }
+
+    SmallVector& operator=(const SmallVector& other) {
+        if (this != &other) {
+            clear();
+            Append(other.begin(), other.end());
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other) noexcept {
+        if (this != &other) {
+            heap_.reset();
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    void push_back(const T& value) {
+        if (size_ == capacity_) {
+            // value может лежать в этом же векторе
+            const T copy = value;
+            Reserve(capacity_ * 2);
+            data_[size_++] = copy;
+            return;
+        }
+        data_[size_++] = value;
+    }
+
+    template <typename Iterator>
+    void Append(Iterator first, Iterator last) {
+        for (; first != last; ++first) {
+            push_back(*first);
+        }
+    }
+
+    // Удаляет [first, last), сдвигая хвост
+    void erase(iterator first, iterator last) {
+        const iterator tail_end = std::copy(last, end(), first);
+        size_ = static_cast<size_t>(tail_end - data_);
+    }
+
+    void Reserve(size_t capacity) {
+        if (capacity <= capacity_) {
+            return;
+        }
+        auto heap = std::make_unique<T[]>(capacity);
+        std::copy(begin(), end(), heap.get());
+        heap_ = std::move(heap);
+        data_ = heap_.get();
+        capacity_ = capacity;
+    }
+
+    void clear() {
+        size_ = 0;
+    }
+
+    T& operator[](size_t index) {
+        return data_[index];
+    }
+
+    const T& operator[](size_t index) const {
+        return data_[index];
+    }
+
+    T* data() {
+        return data_;
+    }
+
+    const T* data() const {
+        return data_;
+    }
+
+    iterator begin() {
+        return data_;
+    }
+
+    iterator end() {
+        return data_ + size_;
+    }
+
+    const_iterator begin() const {
+        return data_;
+    }
+
+    const_iterator end() const {
+        return data_ + size_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    // Элементы хранятся в самом объекте
+    bool IsInline() const {
+        return heap_ == nullptr;
+    }
+
+private:
+    void MoveFrom(SmallVector& other) {
+        if (other.IsInline()) {
+            data_ = inline_;
+            capacity_ = N;
+            std::copy(other.begin(), other.end(), inline_);
+        }
+        else {
+            heap_ = std::move(other.heap_);
+            data_ = heap_.get();
+            capacity_ = other.capacity_;
+        }
+        size_ = other.size_;
+        other.data_ = other.inline_;
+        other.capacity_ = N;
+        other.size_ = 0;
+    }
+
+    T inline_[N];
+    std::unique_ptr<T[]> heap_;
+    T* data_ = inline_;
+    size_t size_ = 0;
+    size_t capacity_ = N;
+};
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Операции над отсортированными по возрастанию массивами уникальных id.
+// На x86 сравнение идёт блоками по 4 (SSE2) или 8 (AVX2) элементов,
+// на остальных платформах работает скалярное слияние.
+// IntersectSorted и DifferenceSorted допускают out == lhs
+size_t IntersectSorted(const int* lhs, size_t lhs_size, const int* rhs, size_t rhs_size, int* out);
+size_t DifferenceSorted(const int* lhs, size_t lhs_size, const int* rhs, size_t rhs_size, int* out);
+// out должен вмещать lhs_size + rhs_size элементов и не пересекаться с входами
+size_t UnionSorted(const int* lhs, size_t lhs_size, const int* rhs, size_t rhs_size, int* out);
+
+void IntersectInPlace(std::vector<int>& ids, const std::vector<int>& other);
+void SubtractInPlace(std::vector<int>& ids, const std::vector<int>& other);
+std::vector<int> UnionSorted(const std::vector<int>& lhs, const std::vector<int>& rhs);
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Хранилище строк, в которое можно только дописывать. Строки кладутся подряд
+// в куски по CHUNK_SIZE байт и никогда не перемещаются, поэтому string_view
+// на них действительны, пока жива арена
+class StringArena {
+public:
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    StringArena() = default;
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+    StringArena(StringArena&&) = default;
+    StringArena& operator=(StringArena&&) = default;
+
+    // Копирует строку в арену и возвращает представление копии; пустая строка
+    // не копируется
+    std::string_view Store(std::string_view text);
+
+    // Выделенная память, включая незаполненный остаток текущего куска
+    size_t GetMemoryUsage() const {
+        return allocated_;
+    }
+
+private:
+    std::vector<std::unique_ptr<char[]>> chunks_;
+    char* position_ = nullptr;
+    size_t remaining_ = 0;
+    size_t allocated_ = 0;
+};
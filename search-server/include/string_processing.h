@@ -1,11 +1,148 @@
 #pragma once
- 
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <set>
- 
+
+struct TokenizerOptions {
+    // Символы, разделяющие слова
+    std::string_view separators = " ";
+    // Пропускать пустые слова между соседними разделителями. Без этого
+    // токенизатор ведёт себя как SplitIntoWords и возвращает их
+    bool skip_empty_words = false;
+};
+
+// Слово текста. has_control_chars — в слове есть символ с кодом меньше пробела,
+// не входящий в разделители; такие слова сервер не принимает
+struct Token {
+    std::string_view word;
+    bool has_control_chars;
+
+    operator std::string_view() const {
+        return word;
+    }
+};
+
+class TokenRange;
+
+// Делит текст на слова без выделения памяти. Разделители и управляющие символы
+// ищутся за один проход блоками по 64 байта (SSE2 или AVX2, если они доступны
+// при сборке, иначе побайтно), так что проверка слов не требует второго прохода.
+// Объект неизменяем, его можно делить между потоками
+class Tokenizer {
+public:
+    explicit Tokenizer(const TokenizerOptions& options = {});
+
+    // Ленивый диапазон слов text; text должен жить, пока диапазон обходится
+    TokenRange Tokenize(std::string_view text) const;
+    // Заменяет содержимое tokens словами text, переиспользуя память вектора
+    void Tokenize(std::string_view text, std::vector<Token>& tokens) const;
+
+    bool IsSkippingEmptyWords() const {
+        return skip_empty_words_;
+    }
+
+private:
+    friend class TokenRange;
+
+    static constexpr size_t CHUNK_SIZE = 64;
+    // Больше разделителей векторный путь не сравнивает, дальше — таблица
+    static constexpr size_t MAX_VECTOR_SEPARATORS = 8;
+
+    // Биты разделителей и управляющих символов (кроме разделителей)
+    // для size <= CHUNK_SIZE байт, начиная с data
+    void ClassifyChunk(const char* data, size_t size, uint64_t& separators, uint64_t& control_chars) const;
+
+    std::array<bool, 256> is_separator_{};
+    std::array<char, MAX_VECTOR_SEPARATORS> vector_separators_{};
+    size_t vector_separator_count_ = 0; // 0 — разделителей слишком много для векторного пути
+    bool skip_empty_words_;
+};
+
+class TokenRange {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Token;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Token*;
+        using reference = const Token&;
+
+        Iterator() = default;
+
+        reference operator*() const {
+            return token_;
+        }
+
+        pointer operator->() const {
+            return &token_;
+        }
+
+        Iterator& operator++() {
+            Advance();
+            return *this;
+        }
+
+        // Все итераторы в конце равны между собой, остальные сравниваются по позиции
+        bool operator==(const Iterator& other) const {
+            return is_end_ == other.is_end_ && (is_end_ || next_begin_ == other.next_begin_);
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        friend class TokenRange;
+
+        Iterator(const Tokenizer* tokenizer, std::string_view text);
+
+        // Читает следующее слово или переходит в конец
+        void Advance();
+        // Позиция ближайшего разделителя не раньше begin или размер текста
+        size_t FindWordEnd(size_t begin, bool& has_control_chars);
+
+        const Tokenizer* tokenizer_ = nullptr;
+        std::string_view text_;
+        size_t next_begin_ = 0;
+        bool is_end_ = true;
+        Token token_{};
+        // Разобранный блок текста [chunk_begin_, chunk_begin_ + chunk_size_)
+        size_t chunk_begin_ = 0;
+        size_t chunk_size_ = 0;
+        uint64_t chunk_separators_ = 0;
+        uint64_t chunk_control_chars_ = 0;
+    };
+
+    Iterator begin() const {
+        return Iterator(tokenizer_, text_);
+    }
+
+    Iterator end() const {
+        return Iterator();
+    }
+
+private:
+    friend class Tokenizer;
+
+    TokenRange(const Tokenizer* tokenizer, std::string_view text)
+        : tokenizer_(tokenizer)
+        , text_(text) {
+    }
+
+    const Tokenizer* tokenizer_;
+    std::string_view text_;
+};
+
+// Слова, разделённые пробелами, включая пустые
 std::vector<std::string_view> SplitIntoWords(std::string_view text);
- 
+
 template <typename StringContainer>
 std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
     std::set<std::string, std::less<>> non_empty_strings;
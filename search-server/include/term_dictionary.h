@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "string_arena.h"
+
+using TermId = uint32_t;
+
+// Термин документа и его TF. Раскладка — часть формата файла индекса
+struct DocumentTerm {
+    TermId term_id;
+    double term_freq;
+};
+
+// Словарь терминов: каждое слово хранится один раз в арене словаря, а индекс
+// работает с плотными целочисленными идентификаторами вместо строк. Все
+// string_view, которые отдаёт сервер, указывают в арену или в отображённый файл
+class TermDictionary {
+public:
+    static constexpr TermId NO_TERM = std::numeric_limits<TermId>::max();
+
+    TermDictionary() = default;
+    // Копия складывает свои термины в собственную арену; отображённые термины
+    // остаются общими с исходным словарём
+    TermDictionary(const TermDictionary& other);
+    TermDictionary& operator=(const TermDictionary& other);
+    TermDictionary(TermDictionary&&) = default;
+    TermDictionary& operator=(TermDictionary&&) = default;
+
+    TermId Intern(std::string_view word);
+    TermId Find(std::string_view word) const;
+
+    std::string_view GetTerm(TermId term_id) const {
+        if (term_id < mapped_count_) {
+            return { mapped_bytes_ + mapped_offsets_[term_id], mapped_offsets_[term_id + 1] - mapped_offsets_[term_id] };
+        }
+        return terms_[term_id - mapped_count_];
+    }
+
+    size_t size() const {
+        return mapped_count_ + terms_.size();
+    }
+
+    size_t GetMemoryUsage() const;
+
+    // Подключает термины из файла индекса к пустому словарю без копирования:
+    // строки терминов лежат подряд в bytes, offsets содержит term_count + 1 границ,
+    // sorted_ids — идентификаторы в порядке строк, по ним идёт двоичный поиск.
+    // Новые термины получают идентификаторы после отображённых
+    void Map(const char* bytes, const uint64_t* offsets, const TermId* sorted_ids, TermId term_count);
+
+private:
+    TermId FindMapped(std::string_view word) const;
+
+    const char* mapped_bytes_ = nullptr;
+    const uint64_t* mapped_offsets_ = nullptr;
+    const TermId* mapped_sorted_ids_ = nullptr;
+    TermId mapped_count_ = 0;
+
+    StringArena storage_;
+    std::vector<std::string_view> terms_;
+    std::unordered_map<std::string_view, TermId> term_ids_;
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct ThreadPoolOptions {
+    // Число рабочих потоков; вызывающий ParallelFor поток работает вместе с ними
+    size_t thread_count = std::max(1u, std::thread::hardware_concurrency()) - 1;
+    // Поток i закрепляется за ядром cpu_ids[i % cpu_ids.size()], пустой список — без привязки
+    std::vector<int> cpu_ids;
+};
+
+// Постоянный пул потоков с перехватом задач. У каждого потока своя очередь:
+// владелец берёт задачи с конца, остальные при простое забирают их с начала.
+// Задачи запроса раздаются через ParallelFor без порождения новых потоков
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t thread_count);
+    explicit ThreadPool(const ThreadPoolOptions& options);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t GetThreadCount() const {
+        return workers_.size();
+    }
+
+    // Вызывает func(i) для каждого i из [0, count) и возвращается, когда все вызовы
+    // завершены. Вызывающий поток тоже разбирает индексы, поэтому вложенные вызовы
+    // из задач пула не приводят к взаимоблокировке. Вложенный вызов зовёт на помощь
+    // не больше потоков, чем сейчас простаивает, так что параллельность внутри
+    // запроса не создаёт лишней нагрузки, когда пул уже занят запросами целиком.
+    // Первое исключение из func пробрасывается вызывающему
+    template <typename Func>
+    void ParallelFor(size_t count, Func&& func);
+
+    // Общий пул для SearchServer и ProcessQueries
+    static ThreadPool& GetDefault();
+    // Задаёт параметры общего пула. Вызывается до первого GetDefault,
+    // иначе бросает std::logic_error
+    static void ConfigureDefault(const ThreadPoolOptions& options);
+
+private:
+    struct ParallelForState {
+        std::atomic<size_t> next_index = 0;
+        size_t count = 0;
+        size_t completed = 0;
+        std::function<void(size_t)> body;
+        std::exception_ptr exception;
+        std::mutex mutex;
+        std::condition_variable done;
+
+        // Разбирает индексы, пока они есть
+        void Run();
+    };
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool IsOwnWorkerThread() const;
+    // Сколько помощников звать для ParallelFor на count индексов
+    size_t CountHelpers(size_t count) const;
+    void Submit(std::function<void()> task);
+    bool TryTakeTask(size_t worker_index, std::function<void()>& task);
+    void WorkerLoop(size_t worker_index);
+    void PinWorker(size_t worker_index, int cpu_id);
+    void Stop();
+
+    std::vector<std::thread> workers_;
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::atomic<size_t> next_queue_ = 0;
+    // Число задач в очередях; растёт под sleep_mutex_, чтобы не терять пробуждения
+    std::atomic<size_t> pending_tasks_ = 0;
+    std::atomic<size_t> idle_workers_ = 0;
+    std::mutex sleep_mutex_;
+    std::condition_variable has_tasks_;
+    bool stopping_ = false;
+};
+
+template <typename Func>
+void ThreadPool::ParallelFor(size_t count, Func&& func) {
+    if (count == 0) {
+        return;
+    }
+    const size_t helper_count = CountHelpers(count);
+    if (helper_count == 0) {
+        for (size_t i = 0; i < count; ++i) {
+            func(i);
+        }
+        return;
+    }
+
+    // Состояние живёт в shared_ptr: помощник, запущенный уже после завершения,
+    // не найдёт свободных индексов и не тронет кадр стека вызывающего
+    auto state = std::make_shared<ParallelForState>();
+    state->count = count;
+    state->body = [&func](size_t i) { func(i); };
+
+    for (size_t i = 0; i < helper_count; ++i) {
+        Submit([state] { state->Run(); });
+    }
+    state->Run();
+
+    // Ожидание только индексов, которые уже выполняются другими потоками.
+    // Чужие задачи здесь не берутся: поток может быть посреди своего запроса
+    std::unique_lock lock(state->mutex);
+    state->done.wait(lock, [&state] { return state->completed == state->count; });
+    if (state->exception) {
+        std::rethrow_exception(state->exception);
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "document.h"
+
+// Ограниченная куча лучших документов в порядке Order (IsMoreRelevant или
+// IsMoreRelevantStrict). В вершине хранится худший из отобранных, поэтому
+// проверка кандидата стоит O(1), а вставка — O(log K)
+template <bool (*Order)(const Document&, const Document&)>
+class BasicTopDocuments {
+public:
+    explicit BasicTopDocuments(size_t capacity)
+        : capacity_(capacity) {
+    }
+
+    bool IsFull() const {
+        return documents_.size() == capacity_;
+    }
+
+    const Document& GetWorst() const {
+        return documents_.front();
+    }
+
+    // Может ли документ с такими параметрами попасть в выдачу
+    bool Accepts(const Document& document) const {
+        return !IsFull() || (capacity_ > 0 && Order(document, GetWorst()));
+    }
+
+    void Push(const Document& document) {
+        if (!Accepts(document)) {
+            return;
+        }
+        if (IsFull()) {
+            std::pop_heap(documents_.begin(), documents_.end(), Order);
+            documents_.back() = document;
+        }
+        else {
+            documents_.push_back(document);
+        }
+        std::push_heap(documents_.begin(), documents_.end(), Order);
+    }
+
+    // Документы от лучшего к худшему
+    std::vector<Document> Extract() {
+        std::sort(documents_.begin(), documents_.end(), Order);
+        return std::move(documents_);
+    }
+
+private:
+    size_t capacity_;
+    std::vector<Document> documents_;
+};
+
+using TopDocuments = BasicTopDocuments<IsMoreRelevant>;
@@ -0,0 +1,139 @@
+#include "concurrent_search_server.h"
+
+#include <functional>
+#include <thread>
+
+namespace {
+
+// По нему поток выбирает полосу счётчика читателей
+size_t GetThreadHash() {
+    thread_local const size_t thread_hash = std::hash<std::thread::id>()(std::this_thread::get_id());
+    return thread_hash;
+}
+
+} // namespace
+
+bool ConcurrentSearchServer::ReaderIndicator::IsEmpty() const {
+    for (const Stripe& stripe : stripes_) {
+        if (stripe.count.load() != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+ConcurrentSearchServer::ReadGuard::ReadGuard(const ConcurrentSearchServer& server)
+    : indicator_(server.readers_[server.version_.load()])
+    , stripe_(GetThreadHash() % ReaderIndicator::STRIPE_COUNT) {
+    indicator_.Arrive(stripe_);
+}
+
+ConcurrentSearchServer::ReadGuard::~ReadGuard() {
+    indicator_.Depart(stripe_);
+}
+
+ConcurrentSearchServer::ConcurrentSearchServer(const std::string& stop_words_text)
+    : instances_{ std::make_unique<SearchServer>(stop_words_text), std::make_unique<SearchServer>(stop_words_text) } {
+}
+
+ConcurrentSearchServer::ConcurrentSearchServer(SearchServer&& left, SearchServer&& right)
+    : instances_{ std::make_unique<SearchServer>(std::move(left)), std::make_unique<SearchServer>(std::move(right)) } {
+}
+
+ConcurrentSearchServer ConcurrentSearchServer::OpenIndex(const std::string& path, bool verify) {
+    // Вторая копия разделяет отображение первой: файл открывается и проверяется один раз
+    SearchServer server = SearchServer::OpenIndex(path, verify);
+    SearchServer copy = server;
+    return ConcurrentSearchServer(std::move(server), std::move(copy));
+}
+
+PreparedQuery ConcurrentSearchServer::PrepareQuery(std::string_view raw_query) const {
+    return Read([raw_query](const SearchServer& server) {
+        return server.PrepareQuery(raw_query);
+    });
+}
+
+int ConcurrentSearchServer::GetDocumentCount() const {
+    return Read([](const SearchServer& server) {
+        return server.GetDocumentCount();
+    });
+}
+
+void ConcurrentSearchServer::SaveIndex(const std::string& path) const {
+    Read([&path](const SearchServer& server) {
+        server.SaveIndex(path);
+    });
+}
+
+void ConcurrentSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    Write([&](SearchServer& server) {
+        server.AddDocument(document_id, document, status, ratings);
+    });
+}
+
+void ConcurrentSearchServer::AddDocuments(const std::vector<NewDocument>& documents) {
+    Write([&documents](SearchServer& server) {
+        server.AddDocuments(documents);
+    });
+}
+
+void ConcurrentSearchServer::RemoveDocument(int document_id) {
+    Write([document_id](SearchServer& server) {
+        server.RemoveDocument(document_id);
+    });
+}
+
+void ConcurrentSearchServer::RemoveDocuments(const std::vector<int>& document_ids) {
+    Write([&document_ids](SearchServer& server) {
+        server.RemoveDocuments(document_ids);
+    });
+}
+
+void ConcurrentSearchServer::CompactIndex() {
+    Write([](SearchServer& server) {
+        server.CompactIndex();
+    });
+}
+
+void ConcurrentSearchServer::SetRankingMode(RankingMode mode) {
+    Write([mode](SearchServer& server) {
+        server.SetRankingMode(mode);
+    });
+}
+
+void ConcurrentSearchServer::SetQuerySyntax(QuerySyntax syntax) {
+    Write([syntax](SearchServer& server) {
+        server.SetQuerySyntax(syntax);
+    });
+}
+
+void ConcurrentSearchServer::SetThreadPool(ThreadPool& thread_pool) {
+    Write([&thread_pool](SearchServer& server) {
+        server.SetThreadPool(thread_pool);
+    });
+}
+
+void ConcurrentSearchServer::PublishStandby() {
+    active_.store(1 - active_.load());
+    // Новые читатели уже видят новую копию, но отметиться они могут в любом из
+    // индикаторов. Сначала дожидаемся опустения свободного индикатора, переводим
+    // в него входящих, затем ждём ухода всех, кто отметился в прежнем
+    const int previous_version = version_.load();
+    const int next_version = 1 - previous_version;
+    while (!readers_[next_version].IsEmpty()) {
+        std::this_thread::yield();
+    }
+    version_.store(next_version);
+    while (!readers_[previous_version].IsEmpty()) {
+        std::this_thread::yield();
+    }
+}
+
+void ConcurrentSearchServer::RestoreInstance(int index) {
+    try {
+        instances_[index] = std::make_unique<SearchServer>(*instances_[1 - index]);
+    }
+    catch (...) {
+        failed_ = true;
+    }
+}
@@ -1,5 +1,7 @@
 #include "document.h"
 
+#include <cmath>
+
 Document::Document() = default;
 
 Document::Document(int id, double relevance, int rating)
@@ -8,6 +10,26 @@ Document::Document(int id, double relevance, int rating)
     , rating(rating) {
 }
 
+bool IsMoreRelevant(const Document& lhs, const Document& rhs) {
+    if (std::abs(lhs.relevance - rhs.relevance) < DEVIATION) {
+        if (lhs.rating != rhs.rating) {
+            return lhs.rating > rhs.rating;
+        }
+        return lhs.id < rhs.id;
+    }
+    return lhs.relevance > rhs.relevance;
+}
+
+bool IsMoreRelevantStrict(const Document& lhs, const Document& rhs) {
+    if (lhs.relevance != rhs.relevance) {
+        return lhs.relevance > rhs.relevance;
+    }
+    if (lhs.rating != rhs.rating) {
+        return lhs.rating > rhs.rating;
+    }
+    return lhs.id < rhs.id;
+}
+
 std::ostream& operator<<(std::ostream & out, const Document & document) {
     out << "{ "s
         << "document_id = "s << document.id << ", "s
@@ -0,0 +1,61 @@
+#include "document_table.h"
+
+#include <algorithm>
+
+void DocumentTable::Add(int id, int rating, DocumentStatus status, double inv_word_count, bool is_removed) {
+    ids_.push_back(id);
+    ratings_.push_back(rating);
+    statuses_.push_back(status);
+    inv_word_counts_.push_back(inv_word_count);
+    is_removed_.PushBack(is_removed);
+    is_live_.PushBack(!is_removed);
+    for (size_t i = 0; i < STATUS_COUNT; ++i) {
+        status_bitmaps_[i].PushBack(!is_removed && static_cast<size_t>(status) == i);
+    }
+}
+
+void DocumentTable::Reserve(size_t size) {
+    ids_.reserve(size);
+    ratings_.reserve(size);
+    statuses_.reserve(size);
+    inv_word_counts_.reserve(size);
+    is_removed_.Reserve(size);
+    is_live_.Reserve(size);
+    for (DocumentBitmap& bitmap : status_bitmaps_) {
+        bitmap.Reserve(size);
+    }
+}
+
+void DocumentTable::MarkRemoved(int ordinal) {
+    is_removed_.Set(ordinal);
+    is_live_.Reset(ordinal);
+    status_bitmaps_[static_cast<size_t>(statuses_[ordinal])].Reset(ordinal);
+}
+
+const std::vector<uint64_t>& RatingRangeFilter::GetBitmap(const DocumentTable& table, std::vector<uint64_t>& buffer) const {
+    const std::vector<uint64_t>& base = status ? table.GetStatusBitmap(*status).GetWords() : table.GetLiveBitmap().GetWords();
+    const std::vector<int>& ratings = table.GetRatings();
+    buffer.assign(base.size(), 0);
+    if (min_rating > max_rating) {
+        return buffer;
+    }
+    const uint32_t range = static_cast<uint32_t>(max_rating) - static_cast<uint32_t>(min_rating);
+    for (size_t word = 0; word < base.size(); ++word) {
+        if (base[word] == 0) {
+            continue;
+        }
+        // Одно беззнаковое сравнение на рейтинг, без ветвлений: компилятор векторизует цикл
+        const int* word_ratings = ratings.data() + word * 64;
+        const size_t count = std::min<size_t>(64, ratings.size() - word * 64);
+        uint8_t accepted[64] = {};
+        for (size_t i = 0; i < count; ++i) {
+            accepted[i] = static_cast<uint32_t>(word_ratings[i]) - static_cast<uint32_t>(min_rating) <= range;
+        }
+        uint64_t bits = 0;
+        for (size_t i = 0; i < 64; ++i) {
+            bits |= static_cast<uint64_t>(accepted[i]) << i;
+        }
+        buffer[word] = base[word] & bits;
+    }
+    return buffer;
+}
@@ -0,0 +1,60 @@
+#include "flat_string_set.h"
+
+#include <functional>
+
+void FlatStringSet::Insert(std::string_view str) {
+    if (Contains(str)) {
+        return;
+    }
+    if ((size_ + 1) * 2 > slots_.size()) {
+        Rehash(slots_.empty() ? 16 : slots_.size() * 2);
+    }
+    const uint64_t hash = Hash(str);
+    const size_t mask = slots_.size() - 1;
+    size_t position = hash & mask;
+    while (slots_[position].length != EMPTY_SLOT) {
+        position = (position + 1) & mask;
+    }
+    slots_[position] = { hash, static_cast<uint32_t>(bytes_.size()), static_cast<uint32_t>(str.size()) };
+    bytes_ += str;
+    ++size_;
+}
+
+bool FlatStringSet::Contains(std::string_view str) const {
+    if (size_ == 0) {
+        return false;
+    }
+    const uint64_t hash = Hash(str);
+    const size_t mask = slots_.size() - 1;
+    for (size_t position = hash & mask; slots_[position].length != EMPTY_SLOT; position = (position + 1) & mask) {
+        const Slot& slot = slots_[position];
+        if (slot.hash == hash && GetString(slot) == str) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t FlatStringSet::Hash(std::string_view str) {
+    return std::hash<std::string_view>{}(str);
+}
+
+std::string_view FlatStringSet::GetString(const Slot& slot) const {
+    return std::string_view(bytes_).substr(slot.offset, slot.length);
+}
+
+void FlatStringSet::Rehash(size_t slot_count) {
+    std::vector<Slot> slots(slot_count, Slot{ 0, 0, EMPTY_SLOT });
+    const size_t mask = slot_count - 1;
+    for (const Slot& slot : slots_) {
+        if (slot.length == EMPTY_SLOT) {
+            continue;
+        }
+        size_t position = slot.hash & mask;
+        while (slots[position].length != EMPTY_SLOT) {
+            position = (position + 1) & mask;
+        }
+        slots[position] = slot;
+    }
+    slots_ = std::move(slots);
+}
@@ -0,0 +1,21 @@
+#include "index_format.h"
+
+#include <cstring>
+
+uint64_t ComputeIndexChecksum(const uint8_t* data, size_t size, uint64_t seed) {
+    static constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+    uint64_t hash = seed;
+    size_t position = 0;
+    for (; position + sizeof(uint64_t) <= size; position += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, data + position, sizeof(word));
+        hash = (hash ^ word) * FNV_PRIME;
+    }
+    if (position < size) {
+        uint64_t word = 0;
+        std::memcpy(&word, data + position, size - position);
+        hash = (hash ^ word) * FNV_PRIME;
+    }
+    return hash;
+}
@@ -0,0 +1,54 @@
+#include "mapped_file.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open " + path + ": " + std::strerror(errno));
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        const int error = errno;
+        close(fd);
+        throw std::runtime_error("Cannot stat " + path + ": " + std::strerror(error));
+    }
+    size_ = static_cast<size_t>(file_stat.st_size);
+    if (size_ > 0) {
+        void* address = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED) {
+            const int error = errno;
+            close(fd);
+            throw std::runtime_error("Cannot map " + path + ": " + std::strerror(error));
+        }
+        data_ = static_cast<const uint8_t*>(address);
+    }
+    // Отображение остаётся действительным и после закрытия дескриптора
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+}
+
+std::string CreateUniqueFile(const std::string& directory, const std::string& prefix, const std::string& suffix) {
+    std::string path = directory + "/" + prefix + "XXXXXX" + suffix;
+    const int fd = mkstemps(path.data(), static_cast<int>(suffix.size()));
+    if (fd < 0) {
+        throw std::runtime_error("Cannot create a file in " + directory + ": " + std::strerror(errno));
+    }
+    // mkstemps создаёт файл с правами 0600; файл индекса должны читать и другие процессы
+    fchmod(fd, 0644);
+    close(fd);
+    return path;
+}
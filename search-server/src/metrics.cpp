@@ -0,0 +1,169 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace {
+
+int HighestBit(uint64_t value) {
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(value);
+#else
+    int bit = 0;
+    while (value >>= 1) {
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+} // namespace
+
+double HistogramSnapshot::GetMean() const {
+    return count > 0 ? static_cast<double>(sum) / count : 0.0;
+}
+
+uint64_t HistogramSnapshot::GetPercentile(double share) const {
+    if (count == 0) {
+        return 0;
+    }
+    const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::clamp(share, 0.0, 1.0) * count)));
+    uint64_t seen = 0;
+    for (size_t index = 0; index < bucket_counts.size(); ++index) {
+        seen += bucket_counts[index];
+        if (seen >= rank) {
+            return std::min(LatencyHistogram::GetBucketUpperBound(index), max);
+        }
+    }
+    return max;
+}
+
+HistogramSnapshot LatencyHistogram::GetSnapshot() const {
+    HistogramSnapshot snapshot;
+    snapshot.bucket_counts.resize(BUCKET_COUNT);
+    for (size_t index = 0; index < BUCKET_COUNT; ++index) {
+        snapshot.bucket_counts[index] = buckets_[index].load(std::memory_order_relaxed);
+        snapshot.count += snapshot.bucket_counts[index];
+    }
+    snapshot.sum = sum_.load(std::memory_order_relaxed);
+    snapshot.max = max_.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+void LatencyHistogram::Reset() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+size_t LatencyHistogram::GetBucketIndex(uint64_t value) {
+    if (value < SUB_BUCKET_COUNT) {
+        return static_cast<size_t>(value);
+    }
+    // Старший бит и SUB_BUCKET_BITS следующих за ним
+    const int shift = HighestBit(value) - SUB_BUCKET_BITS;
+    const uint64_t sub_bucket = (value >> shift) - SUB_BUCKET_COUNT;
+    return static_cast<size_t>(SUB_BUCKET_COUNT + shift * SUB_BUCKET_COUNT + sub_bucket);
+}
+
+uint64_t LatencyHistogram::GetBucketUpperBound(size_t index) {
+    if (index < SUB_BUCKET_COUNT) {
+        return index;
+    }
+    const size_t shift = (index - SUB_BUCKET_COUNT) / SUB_BUCKET_COUNT;
+    const uint64_t sub_bucket = (index - SUB_BUCKET_COUNT) % SUB_BUCKET_COUNT;
+    const uint64_t lower_bound = (SUB_BUCKET_COUNT + sub_bucket) << shift;
+    return lower_bound + ((uint64_t{ 1 } << shift) - 1);
+}
+
+MetricsRegistry& MetricsRegistry::Global() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+LatencyHistogram& MetricsRegistry::GetHistogram(std::string_view name) {
+    std::lock_guard lock(mutex_);
+    auto it = histograms_.find(name);
+    if (it == histograms_.end()) {
+        it = histograms_.emplace(std::string(name), std::make_unique<LatencyHistogram>()).first;
+    }
+    return *it->second;
+}
+
+MetricsCounter& MetricsRegistry::GetCounter(std::string_view name) {
+    std::lock_guard lock(mutex_);
+    auto it = counters_.find(name);
+    if (it == counters_.end()) {
+        it = counters_.emplace(std::string(name), std::make_unique<MetricsCounter>()).first;
+    }
+    return *it->second;
+}
+
+MetricsSnapshot MetricsRegistry::GetSnapshot() const {
+    MetricsSnapshot snapshot;
+    std::lock_guard lock(mutex_);
+    for (const auto& [name, histogram] : histograms_) {
+        snapshot.histograms.emplace(name, histogram->GetSnapshot());
+    }
+    for (const auto& [name, counter] : counters_) {
+        snapshot.counters.emplace(name, counter->Get());
+    }
+    return snapshot;
+}
+
+std::string MetricsRegistry::DumpText() const {
+    const MetricsSnapshot snapshot = GetSnapshot();
+    std::ostringstream out;
+    for (const auto& [name, histogram] : snapshot.histograms) {
+        out << name << " count=" << histogram.count
+            << " mean_ns=" << static_cast<uint64_t>(histogram.GetMean())
+            << " p50_ns=" << histogram.GetPercentile(0.5)
+            << " p90_ns=" << histogram.GetPercentile(0.9)
+            << " p99_ns=" << histogram.GetPercentile(0.99)
+            << " max_ns=" << histogram.max << '\n';
+    }
+    for (const auto& [name, value] : snapshot.counters) {
+        out << name << ' ' << value << '\n';
+    }
+    return out.str();
+}
+
+std::string MetricsRegistry::DumpJson() const {
+    // Имена метрик — идентификаторы из кода, экранировать в них нечего
+    const MetricsSnapshot snapshot = GetSnapshot();
+    std::ostringstream out;
+    out << "{\"histograms\": {";
+    bool first = true;
+    for (const auto& [name, histogram] : snapshot.histograms) {
+        out << (first ? "" : ", ") << '"' << name << "\": {\"count\": " << histogram.count
+            << ", \"sum_ns\": " << histogram.sum
+            << ", \"mean_ns\": " << histogram.GetMean()
+            << ", \"p50_ns\": " << histogram.GetPercentile(0.5)
+            << ", \"p90_ns\": " << histogram.GetPercentile(0.9)
+            << ", \"p99_ns\": " << histogram.GetPercentile(0.99)
+            << ", \"p999_ns\": " << histogram.GetPercentile(0.999)
+            << ", \"max_ns\": " << histogram.max << '}';
+        first = false;
+    }
+    out << "}, \"counters\": {";
+    first = true;
+    for (const auto& [name, value] : snapshot.counters) {
+        out << (first ? "" : ", ") << '"' << name << "\": " << value;
+        first = false;
+    }
+    out << "}}";
+    return out.str();
+}
+
+void MetricsRegistry::Reset() {
+    std::lock_guard lock(mutex_);
+    for (const auto& [name, histogram] : histograms_) {
+        histogram->Reset();
+    }
+    for (const auto& [name, counter] : counters_) {
+        counter->Reset();
+    }
+}
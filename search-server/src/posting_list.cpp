@@ -0,0 +1,234 @@
+#include "posting_list.h"
+
+#include <algorithm>
+
+namespace {
+
+void WriteVarint(std::vector<uint8_t>& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+// Как PostingList::ReadVarint, но не выходит за end и не принимает больше 5 байт
+bool ReadVarintChecked(const uint8_t*& cursor, const uint8_t* end, uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 35 && cursor != end; shift += 7) {
+        const uint8_t byte = *cursor++;
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PostingLess(const Posting& lhs, const Posting& rhs) {
+    return lhs.ordinal < rhs.ordinal;
+}
+
+// Разности номеров от first_ordinal блока и числа вхождений
+void EncodePostings(std::vector<uint8_t>& out, const Posting* begin, const Posting* end) {
+    int previous_ordinal = begin->ordinal;
+    for (const Posting* posting = begin; posting != end; ++posting) {
+        WriteVarint(out, static_cast<uint32_t>(posting->ordinal - previous_ordinal));
+        WriteVarint(out, posting->term_count);
+        previous_ordinal = posting->ordinal;
+    }
+}
+
+} // namespace
+
+void PostingList::Add(int ordinal, uint32_t term_count, double term_freq) {
+    Detach();
+    max_term_freq_ = std::max(max_term_freq_, term_freq);
+    if (blocks_.empty() || ordinal > blocks_.back().last_ordinal) {
+        tail_max_term_freq_ = std::max(tail_max_term_freq_, term_freq);
+        const auto it = std::lower_bound(tail_.begin(), tail_.end(), Posting{ ordinal, 0 }, PostingLess);
+        if (it != tail_.end() && it->ordinal == ordinal) {
+            it->term_count = term_count;
+            return;
+        }
+        tail_.insert(it, { ordinal, term_count });
+        ++size_;
+        if (tail_.size() == BLOCK_SIZE) {
+            FlushTail();
+        }
+        return;
+    }
+
+    const size_t block_index = FindBlock(ordinal);
+    auto postings = DecodeBlock(block_index);
+    const auto it = std::lower_bound(postings.begin(), postings.end(), Posting{ ordinal, 0 }, PostingLess);
+    if (it != postings.end() && it->ordinal == ordinal) {
+        it->term_count = term_count;
+    }
+    else {
+        postings.insert(it, { ordinal, term_count });
+        ++size_;
+    }
+    blocks_[block_index].max_term_freq = std::max(blocks_[block_index].max_term_freq, term_freq);
+    ReplaceBlock(block_index, postings);
+}
+
+bool PostingList::Contains(int ordinal) const {
+    const Iterator it = LowerBound(ordinal);
+    return it != end() && it->ordinal == ordinal;
+}
+
+PostingList::Iterator PostingList::LowerBound(int ordinal) const {
+    const size_t block_index = FindBlock(ordinal);
+    if (block_index == GetBlockCount()) {
+        const auto tail_it = std::lower_bound(tail_.begin(), tail_.end(), Posting{ ordinal, 0 }, PostingLess);
+        return Iterator(this, block_index, static_cast<uint32_t>(tail_it - tail_.begin()));
+    }
+    Iterator it(this, block_index, 0);
+    while (it->ordinal < ordinal) {
+        ++it;
+    }
+    return it;
+}
+
+void PostingList::DecodeOrdinals(std::vector<int>& ordinals) const {
+    ordinals.clear();
+    ordinals.reserve(size_);
+    for (const Posting& posting : *this) {
+        ordinals.push_back(posting.ordinal);
+    }
+}
+
+size_t PostingList::GetMemoryUsage() const {
+    return data_.capacity() * sizeof(uint8_t)
+        + blocks_.capacity() * sizeof(BlockInfo)
+        + tail_.capacity() * sizeof(Posting);
+}
+
+void PostingList::Export(std::vector<BlockInfo>& blocks, std::vector<uint8_t>& data) const {
+    blocks.insert(blocks.end(), GetBlocks(), GetBlocks() + GetBlockCount());
+    data.insert(data.end(), GetData(), GetData() + GetDataSize());
+    if (!tail_.empty()) {
+        blocks.push_back({ tail_.front().ordinal, tail_.back().ordinal, static_cast<uint32_t>(GetDataSize()),
+            static_cast<uint32_t>(tail_.size()), tail_max_term_freq_ });
+        EncodePostings(data, tail_.data(), tail_.data() + tail_.size());
+    }
+}
+
+PostingList PostingList::Map(const BlockInfo* blocks, size_t block_count, const uint8_t* data, size_t data_size,
+                             size_t posting_count, double max_term_freq) {
+    PostingList list;
+    if (block_count > 0) {
+        list.mapped_blocks_ = blocks;
+        list.mapped_block_count_ = block_count;
+        list.mapped_data_ = data;
+        list.mapped_data_size_ = data_size;
+    }
+    list.size_ = posting_count;
+    list.max_term_freq_ = max_term_freq;
+    return list;
+}
+
+bool PostingList::IsValidMapping(const BlockInfo* blocks, size_t block_count, const uint8_t* data, size_t data_size,
+                                 size_t posting_count, int ordinal_count) {
+    const uint8_t* const data_end = data + data_size;
+    size_t total_count = 0;
+    int64_t previous_last = -1;
+    for (size_t i = 0; i < block_count; ++i) {
+        const BlockInfo& block = blocks[i];
+        if (block.count == 0 || block.offset >= data_size || block.first_ordinal <= previous_last
+            || block.last_ordinal < block.first_ordinal || block.last_ordinal >= ordinal_count) {
+            return false;
+        }
+        const uint8_t* cursor = data + block.offset;
+        int64_t ordinal = block.first_ordinal;
+        for (uint32_t j = 0; j < block.count; ++j) {
+            uint32_t delta = 0;
+            uint32_t term_count = 0;
+            if (!ReadVarintChecked(cursor, data_end, delta) || !ReadVarintChecked(cursor, data_end, term_count)
+                || (j == 0) != (delta == 0)) {
+                return false;
+            }
+            ordinal += delta;
+            if (ordinal > block.last_ordinal) {
+                return false;
+            }
+        }
+        if (ordinal != block.last_ordinal) {
+            return false;
+        }
+        previous_last = block.last_ordinal;
+        total_count += block.count;
+    }
+    return total_count == posting_count;
+}
+
+void PostingList::Detach() {
+    if (mapped_blocks_ == nullptr) {
+        return;
+    }
+    blocks_.assign(mapped_blocks_, mapped_blocks_ + mapped_block_count_);
+    data_.assign(mapped_data_, mapped_data_ + mapped_data_size_);
+    mapped_blocks_ = nullptr;
+    mapped_block_count_ = 0;
+    mapped_data_ = nullptr;
+    mapped_data_size_ = 0;
+}
+
+size_t PostingList::FindBlock(int ordinal, size_t first_block) const {
+    const BlockInfo* blocks = GetBlocks();
+    const auto it = std::lower_bound(blocks + first_block, blocks + GetBlockCount(), ordinal,
+        [](const BlockInfo& block, int id) { return block.last_ordinal < id; });
+    return it - blocks;
+}
+
+std::vector<Posting> PostingList::DecodeBlock(size_t block_index) const {
+    const BlockInfo& block = blocks_[block_index];
+    std::vector<Posting> postings;
+    postings.reserve(block.count + 1);
+    const uint8_t* cursor = data_.data() + block.offset;
+    int ordinal = block.first_ordinal;
+    for (uint32_t i = 0; i < block.count; ++i) {
+        ordinal += static_cast<int>(ReadVarint(cursor));
+        postings.push_back({ ordinal, ReadVarint(cursor) });
+    }
+    return postings;
+}
+
+void PostingList::ReplaceBlock(size_t block_index, const std::vector<Posting>& postings) {
+    std::vector<uint8_t> encoded;
+    std::vector<BlockInfo> new_blocks;
+    for (size_t begin = 0; begin < postings.size(); begin += BLOCK_SIZE) {
+        const size_t end = std::min(postings.size(), begin + BLOCK_SIZE);
+        // Граница TF наследуется от исходного блока: она остаётся верной, хоть и может быть завышена
+        BlockInfo block{ postings[begin].ordinal, postings[end - 1].ordinal,
+            static_cast<uint32_t>(encoded.size()), static_cast<uint32_t>(end - begin),
+            blocks_[block_index].max_term_freq };
+        EncodePostings(encoded, postings.data() + begin, postings.data() + end);
+        new_blocks.push_back(block);
+    }
+
+    const uint32_t old_begin = blocks_[block_index].offset;
+    const uint32_t old_end = block_index + 1 < blocks_.size()
+        ? blocks_[block_index + 1].offset
+        : static_cast<uint32_t>(data_.size());
+    const int64_t shift = static_cast<int64_t>(encoded.size()) - (old_end - old_begin);
+
+    data_.erase(data_.begin() + old_begin, data_.begin() + old_end);
+    data_.insert(data_.begin() + old_begin, encoded.begin(), encoded.end());
+    for (BlockInfo& block : new_blocks) {
+        block.offset += old_begin;
+    }
+    for (size_t i = block_index + 1; i < blocks_.size(); ++i) {
+        blocks_[i].offset = static_cast<uint32_t>(blocks_[i].offset + shift);
+    }
+    blocks_.erase(blocks_.begin() + block_index);
+    blocks_.insert(blocks_.begin() + block_index, new_blocks.begin(), new_blocks.end());
+}
+
+void PostingList::FlushTail() {
+    blocks_.push_back({ tail_.front().ordinal, tail_.back().ordinal, static_cast<uint32_t>(data_.size()), 0, tail_max_term_freq_ });
+    ReplaceBlock(blocks_.size() - 1, tail_);
+    tail_.clear();
+    tail_max_term_freq_ = 0.0;
+}
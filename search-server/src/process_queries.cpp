@@ -1,30 +1,35 @@
 #include "process_queries.h"
 
-#include <execution>
-#include <iterator>
+#include <utility>
 
 std::vector<std::vector<Document>> ProcessQueries(
     const SearchServer& search_server,
     const std::vector<std::string>& queries){
     std::vector<std::vector<Document>> result(queries.size());
-    std::transform(std::execution::par, 
-                   std::make_move_iterator(queries.begin()), std::make_move_iterator(queries.end()),
-                   std::make_move_iterator(result.begin()), 
-                   [&search_server](const std::string &query) { 
-                       return search_server.FindTopDocuments(query);}
-                  );   
+    ProcessQueriesStreamed(search_server, queries, [&result](size_t query_index, std::vector<Document>&& documents) {
+        result[query_index] = std::move(documents);
+    }, ResultOrder::AS_COMPLETED);
     return result;
 }
 
 std::vector<Document> ProcessQueriesJoined(
     const SearchServer& search_server,
     const std::vector<std::string>& queries) {
-    auto process_queries = ProcessQueries(search_server, queries);
-    std::vector<Document> result;
-    for (auto vector_result: process_queries) {
-        for (auto document: vector_result) {
-            result.push_back(document);
-        } 
-    }
-    return result;
+    return ProcessQueriesFlat(search_server, queries).documents;
+}
+
+std::vector<std::vector<Document>> ProcessQueries(
+    const ConcurrentSearchServer& search_server,
+    const std::vector<std::string>& queries) {
+    return search_server.Read([&queries](const SearchServer& server) {
+        return ProcessQueries(server, queries);
+    });
+}
+
+std::vector<Document> ProcessQueriesJoined(
+    const ConcurrentSearchServer& search_server,
+    const std::vector<std::string>& queries) {
+    return search_server.Read([&queries](const SearchServer& server) {
+        return ProcessQueriesJoined(server, queries);
+    });
 }
@@ -0,0 +1,68 @@
+#include "query_cache.h"
+
+#include <functional>
+
+QueryCache::QueryCache(size_t capacity)
+    : shard_capacity_((capacity + SHARD_COUNT - 1) / SHARD_COUNT) {
+}
+
+QueryCache::QueryCache(const QueryCache& other)
+    : shard_capacity_(other.shard_capacity_) {
+}
+
+std::optional<std::vector<Document>> QueryCache::Find(const std::string& key, uint64_t generation) {
+    Shard& shard = GetShard(key);
+    {
+        std::lock_guard lock(shard.mutex);
+        const auto it = shard.positions.find(key);
+        if (it != shard.positions.end()) {
+            const auto entry = it->second;
+            if (entry->generation == generation) {
+                shard.entries.splice(shard.entries.begin(), shard.entries, entry);
+                ++hits_;
+                return entry->documents;
+            }
+            shard.positions.erase(it);
+            shard.entries.erase(entry);
+        }
+    }
+    ++misses_;
+    return std::nullopt;
+}
+
+void QueryCache::Insert(const std::string& key, uint64_t generation, const std::vector<Document>& documents) {
+    if (shard_capacity_ == 0) {
+        return;
+    }
+    Shard& shard = GetShard(key);
+    std::lock_guard lock(shard.mutex);
+    if (const auto it = shard.positions.find(key); it != shard.positions.end()) {
+        // Тот же запрос мог посчитать другой поток
+        const auto entry = it->second;
+        entry->generation = generation;
+        entry->documents = documents;
+        shard.entries.splice(shard.entries.begin(), shard.entries, entry);
+        return;
+    }
+    if (shard.entries.size() == shard_capacity_) {
+        shard.positions.erase(shard.entries.back().key);
+        shard.entries.pop_back();
+    }
+    shard.entries.push_front({ key, generation, documents });
+    shard.positions.emplace(shard.entries.front().key, shard.entries.begin());
+}
+
+QueryCacheStats QueryCache::GetStats() const {
+    QueryCacheStats stats;
+    stats.hits = hits_.load();
+    stats.misses = misses_.load();
+    for (const Shard& shard : shards_) {
+        std::lock_guard lock(shard.mutex);
+        stats.size += shard.entries.size();
+    }
+    return stats;
+}
+
+QueryCache::Shard& QueryCache::GetShard(const std::string& key) {
+    return shards_[std::hash<std::string>()(key) % SHARD_COUNT];
+}
@@ -0,0 +1,220 @@
+#include "remove_duplicates.h"
+
+#include <algorithm>
+#include <execution>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+using DocumentTermRange = SearchServer::DocumentTermRange;
+
+// Документов на одну задачу пула: меньшие части не окупают раздачу
+constexpr size_t DOCUMENTS_PER_TASK = 1024;
+
+// Финализатор splitmix64: каждый бит входа влияет на все биты результата
+uint64_t Mix(uint64_t value) {
+    value += 0x9E3779B97F4A7C15;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EB;
+    return value ^ (value >> 31);
+}
+
+struct Fingerprint {
+    uint64_t low;
+    uint64_t high;
+
+    bool operator==(const Fingerprint& other) const {
+        return low == other.low && high == other.high;
+    }
+};
+
+struct FingerprintHasher {
+    size_t operator()(const Fingerprint& fingerprint) const {
+        return static_cast<size_t>(fingerprint.low);
+    }
+};
+
+// Две независимые цепочки по отсортированным идентификаторам терминов
+Fingerprint ComputeFingerprint(DocumentTermRange terms, uint64_t seed) {
+    uint64_t low = seed;
+    uint64_t high = ~seed;
+    for (const DocumentTerm& term : terms) {
+        low = Mix(low ^ term.term_id);
+        high = Mix(high + term.term_id * 0xD6E8FEB86659FD93);
+    }
+    return { Mix(low ^ terms.size()), Mix(high + terms.size()) };
+}
+
+bool HaveSameTerms(DocumentTermRange lhs, DocumentTermRange rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+        [](const DocumentTerm& a, const DocumentTerm& b) { return a.term_id == b.term_id; });
+}
+
+// Мера Жаккара не меньше min_jaccard; множества пустых документов совпадают
+bool IsSimilar(DocumentTermRange lhs, DocumentTermRange rhs, double min_jaccard) {
+    const size_t smaller = std::min(lhs.size(), rhs.size());
+    const size_t larger = std::max(lhs.size(), rhs.size());
+    if (larger == 0) {
+        return true;
+    }
+    // Пересечение не больше меньшего множества, объединение не меньше большего
+    if (smaller < min_jaccard * larger) {
+        return false;
+    }
+    size_t common = 0;
+    const DocumentTerm* left = lhs.begin();
+    const DocumentTerm* right = rhs.begin();
+    while (left != lhs.end() && right != rhs.end()) {
+        if (left->term_id < right->term_id) {
+            ++left;
+        }
+        else if (right->term_id < left->term_id) {
+            ++right;
+        }
+        else {
+            ++common;
+            ++left;
+            ++right;
+        }
+    }
+    return common >= min_jaccard * (lhs.size() + rhs.size() - common);
+}
+
+// func(first, last) для частей [0, count), каждая часть — задача пула
+template <typename Func>
+void ForEachPart(ThreadPool& pool, size_t count, Func func) {
+    const size_t part_count = (count + DOCUMENTS_PER_TASK - 1) / DOCUMENTS_PER_TASK;
+    pool.ParallelFor(part_count, [&](size_t part) {
+        func(part * DOCUMENTS_PER_TASK, std::min(count, (part + 1) * DOCUMENTS_PER_TASK));
+    });
+}
+
+std::vector<int> FindExactDuplicates(const std::vector<int>& document_ids, const std::vector<DocumentTermRange>& document_terms,
+                                     const DuplicateSearchOptions& options, ThreadPool& pool) {
+    const size_t document_count = document_ids.size();
+    std::vector<Fingerprint> fingerprints(document_count);
+    ForEachPart(pool, document_count, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            fingerprints[i] = ComputeFingerprint(document_terms[i], options.seed);
+        }
+    });
+
+    // Документы идут по возрастанию id, так что первым с отпечатком оказывается
+    // документ, который остаётся
+    std::vector<int> duplicates;
+    std::unordered_map<Fingerprint, size_t, FingerprintHasher> first_documents;
+    first_documents.reserve(document_count);
+    for (size_t i = 0; i < document_count; ++i) {
+        const auto [it, inserted] = first_documents.emplace(fingerprints[i], i);
+        if (!inserted && HaveSameTerms(document_terms[it->second], document_terms[i])) {
+            duplicates.push_back(document_ids[i]);
+        }
+    }
+    return duplicates;
+}
+
+std::vector<int> FindNearDuplicates(const std::vector<int>& document_ids, const std::vector<DocumentTermRange>& document_terms,
+                                    const DuplicateSearchOptions& options, ThreadPool& pool) {
+    const size_t document_count = document_ids.size();
+    const size_t band_count = options.band_count;
+    const size_t rows_per_band = options.rows_per_band;
+    const size_t signature_size = band_count * rows_per_band;
+
+    // k-я функция MinHash — перемешанный идентификатор, умноженный на свой
+    // нечётный множитель после XOR со своей солью. Так перемешивание считается
+    // один раз на термин, а не на каждую функцию
+    std::vector<uint64_t> salts(signature_size);
+    std::vector<uint64_t> multipliers(signature_size);
+    for (size_t k = 0; k < signature_size; ++k) {
+        salts[k] = Mix(options.seed + 2 * k);
+        multipliers[k] = Mix(options.seed + 2 * k + 1) | 1;
+    }
+
+    // Подписи не хранятся: от каждой остаются ключи полос
+    std::vector<uint64_t> band_keys(document_count * band_count);
+    ForEachPart(pool, document_count, [&](size_t first, size_t last) {
+        std::vector<uint64_t> signature(signature_size);
+        for (size_t i = first; i < last; ++i) {
+            std::fill(signature.begin(), signature.end(), std::numeric_limits<uint64_t>::max());
+            for (const DocumentTerm& term : document_terms[i]) {
+                const uint64_t hash = Mix(term.term_id ^ options.seed);
+                for (size_t k = 0; k < signature_size; ++k) {
+                    signature[k] = std::min(signature[k], (hash ^ salts[k]) * multipliers[k]);
+                }
+            }
+            for (size_t band = 0; band < band_count; ++band) {
+                uint64_t key = Mix(options.seed ^ band);
+                for (size_t row = 0; row < rows_per_band; ++row) {
+                    key = Mix(key ^ signature[band * rows_per_band + row]);
+                }
+                band_keys[i * band_count + band] = key;
+            }
+        }
+    });
+
+    // В корзинах лежат только оставленные документы, поэтому удалённый документ
+    // не тянет за собой цепочку похожих на него, но не друг на друга
+    std::vector<int> duplicates;
+    std::unordered_map<uint64_t, std::vector<size_t>> buckets;
+    std::vector<size_t> last_checked(document_count, std::numeric_limits<size_t>::max());
+    for (size_t i = 0; i < document_count; ++i) {
+        const uint64_t* keys = band_keys.data() + i * band_count;
+        bool is_duplicate = false;
+        for (size_t band = 0; band < band_count && !is_duplicate; ++band) {
+            const auto bucket = buckets.find(keys[band]);
+            if (bucket == buckets.end()) {
+                continue;
+            }
+            for (const size_t candidate : bucket->second) {
+                // Кандидат, совпавший по нескольким полосам, проверяется один раз
+                if (last_checked[candidate] == i) {
+                    continue;
+                }
+                last_checked[candidate] = i;
+                if (IsSimilar(document_terms[candidate], document_terms[i], options.min_jaccard)) {
+                    is_duplicate = true;
+                    break;
+                }
+            }
+        }
+        if (is_duplicate) {
+            duplicates.push_back(document_ids[i]);
+            continue;
+        }
+        for (size_t band = 0; band < band_count; ++band) {
+            buckets[keys[band]].push_back(i);
+        }
+    }
+    return duplicates;
+}
+
+} // namespace
+
+std::vector<int> FindDuplicates(const SearchServer& search_server, const DuplicateSearchOptions& options) {
+    if (!(options.min_jaccard > 0.0 && options.min_jaccard <= 1.0) || options.band_count == 0 || options.rows_per_band == 0) {
+        throw std::invalid_argument("Invalid duplicate search options");
+    }
+    const std::vector<int> document_ids(search_server.begin(), search_server.end());
+    std::vector<DocumentTermRange> document_terms(document_ids.size());
+    ThreadPool& pool = search_server.GetThreadPool();
+    ForEachPart(pool, document_ids.size(), [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            document_terms[i] = search_server.GetDocumentTermRange(document_ids[i]);
+        }
+    });
+    if (options.min_jaccard == 1.0) {
+        return FindExactDuplicates(document_ids, document_terms, options, pool);
+    }
+    return FindNearDuplicates(document_ids, document_terms, options, pool);
+}
+
+void RemoveDuplicates(SearchServer& search_server, const DuplicateSearchOptions& options) {
+    const std::vector<int> duplicates = FindDuplicates(search_server, options);
+    for (const int document_id : duplicates) {
+        std::cout << "Found duplicate document id "s << document_id << std::endl;
+    }
+    search_server.RemoveDocuments(std::execution::par, duplicates);
+}
@@ -1,20 +1,38 @@
 #include "request_queue.h"
  
-RequestQueue::RequestQueue(const SearchServer& search_server) 
+RequestQueue::RequestQueue(const SearchServer& search_server, RequestStats::Clock::duration bucket_width, size_t bucket_count)
     : search_server_(search_server)
+    , stats_(bucket_width, bucket_count)
 {
 }
  
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentStatus status) {
-    return AddFindRequest(raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-        return document_status == status;
-        });
+    // Запрос по статусу, а не через предикат, чтобы его мог обслужить кеш сервера
+    return Track([&] {
+        return search_server_.FindTopDocuments(raw_query, status);
+    });
 }
  
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query) {
     return AddFindRequest(raw_query, DocumentStatus::ACTUAL);
 }
- 
+
+std::vector<std::vector<Document>> RequestQueue::AddFindRequests(const std::vector<std::string>& raw_queries) {
+    std::vector<std::vector<Document>> results(raw_queries.size());
+    search_server_.GetThreadPool().ParallelFor(raw_queries.size(), [&](size_t i) {
+        results[i] = AddFindRequest(raw_queries[i]);
+    });
+    return results;
+}
+
 int RequestQueue::GetNoResultRequests() const {
-    return count(requests_.begin(), requests_.end(), 0);
+    return static_cast<int>(stats_.GetWindowStats().no_result_count);
+}
+
+RequestWindowStats RequestQueue::GetWindowStats() const {
+    return stats_.GetWindowStats();
+}
+
+RequestWindowStats RequestQueue::GetTotalStats() const {
+    return stats_.GetTotalStats();
 }
@@ -0,0 +1,115 @@
+#include "request_stats.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+double RequestWindowStats::GetMeanLatencyNs() const {
+    return request_count == 0 ? 0.0 : static_cast<double>(latency_sum_ns) / request_count;
+}
+
+double RequestWindowStats::GetNoResultShare() const {
+    return request_count == 0 ? 0.0 : static_cast<double>(no_result_count) / request_count;
+}
+
+void RequestStats::Counters::Add(bool has_results, uint64_t latency_ns) {
+    request_count.fetch_add(1, std::memory_order_relaxed);
+    if (!has_results) {
+        no_result_count.fetch_add(1, std::memory_order_relaxed);
+    }
+    latency_sum_ns.fetch_add(latency_ns, std::memory_order_relaxed);
+}
+
+RequestWindowStats RequestStats::Counters::Load() const {
+    RequestWindowStats stats;
+    stats.request_count = request_count.load(std::memory_order_relaxed);
+    stats.no_result_count = no_result_count.load(std::memory_order_relaxed);
+    stats.latency_sum_ns = latency_sum_ns.load(std::memory_order_relaxed);
+    return stats;
+}
+
+RequestStats::RequestStats(Clock::duration bucket_width, size_t bucket_count)
+    : start_(Clock::now())
+    , bucket_width_(bucket_width)
+    , bucket_count_(bucket_count)
+    , buckets_(std::make_unique<Bucket[]>(bucket_count)) {
+    if (bucket_width <= Clock::duration::zero() || bucket_count == 0) {
+        throw std::invalid_argument("Invalid request stats window");
+    }
+}
+
+uint64_t RequestStats::GetEpoch(Clock::time_point time) const {
+    return time <= start_ ? 0 : static_cast<uint64_t>((time - start_) / bucket_width_);
+}
+
+void RequestStats::Advance(uint64_t epoch) const {
+    uint64_t head = head_epoch_.load(std::memory_order_acquire);
+    while (head < epoch) {
+        // Если с прошлого сдвига прошло больше окна, устарели все корзины:
+        // достаточно очистить корзины последних bucket_count_ эпох, они покрывают всё кольцо
+        const uint64_t next = std::max(head + 1, epoch + 1 >= bucket_count_ ? epoch + 1 - bucket_count_ : 0);
+        if (!head_epoch_.compare_exchange_weak(head, next, std::memory_order_acq_rel)) {
+            continue;
+        }
+        // Корзина достаётся эпохе next, прежнее содержимое уходит из окна. Запись
+        // эпохи next могла занять её раньше нас, тогда очищать уже нечего
+        ClaimBucket(next);
+        head = next;
+    }
+}
+
+bool RequestStats::ClaimBucket(uint64_t epoch) const {
+    Bucket& bucket = buckets_[epoch % bucket_count_];
+    uint64_t owner = bucket.epoch.load(std::memory_order_acquire);
+    while (true) {
+        const uint64_t owner_epoch = owner & ~Bucket::CLAIMING;
+        if (owner_epoch > epoch) {
+            return false;
+        }
+        if (owner == epoch) {
+            return true;
+        }
+        if (owner & Bucket::CLAIMING) {
+            // Другой поток очищает ячейку: это несколько атомарных операций
+            std::this_thread::yield();
+            owner = bucket.epoch.load(std::memory_order_acquire);
+            continue;
+        }
+        if (!bucket.epoch.compare_exchange_weak(owner, epoch | Bucket::CLAIMING, std::memory_order_acq_rel)) {
+            continue;
+        }
+        Counters& counters = bucket.counters;
+        window_.request_count.fetch_sub(counters.request_count.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+        window_.no_result_count.fetch_sub(counters.no_result_count.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+        window_.latency_sum_ns.fetch_sub(counters.latency_sum_ns.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+        bucket.epoch.store(epoch, std::memory_order_release);
+        return true;
+    }
+}
+
+void RequestStats::Record(Clock::time_point time, bool has_results, Clock::duration latency) {
+    const auto latency_ns = static_cast<uint64_t>(std::max<int64_t>(0,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count()));
+    total_.Add(has_results, latency_ns);
+
+    const uint64_t epoch = GetEpoch(time);
+    Advance(epoch);
+    // Запрос, завершившийся раньше, чем окно ушло дальше его корзины, в окно не попадает
+    if (epoch + bucket_count_ <= head_epoch_.load(std::memory_order_acquire) || !ClaimBucket(epoch)) {
+        return;
+    }
+    // Сначала суммы окна, потом корзина: очистка корзины вычитает только то, что
+    // уже есть в суммах, так что они не уходят в минус даже на мгновение. Если
+    // ячейку успели отдать следующему кругу, запрос уйдёт из сумм вместе с ней
+    window_.Add(has_results, latency_ns);
+    buckets_[epoch % bucket_count_].counters.Add(has_results, latency_ns);
+}
+
+RequestWindowStats RequestStats::GetWindowStats(Clock::time_point now) const {
+    Advance(GetEpoch(now));
+    return window_.Load();
+}
+
+RequestWindowStats RequestStats::GetTotalStats() const {
+    return total_.Load();
+}
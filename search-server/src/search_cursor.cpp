@@ -0,0 +1,60 @@
+#include "search_cursor.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+constexpr std::string_view HEX_DIGITS = "0123456789abcdef";
+// Релевантность, рейтинг, id, поколение
+constexpr size_t CURSOR_BYTES = sizeof(double) + sizeof(int32_t) + sizeof(int32_t) + sizeof(uint64_t);
+
+void AppendHex(std::string& text, uint64_t value, size_t byte_count) {
+    for (size_t i = byte_count * 2; i > 0; --i) {
+        text += HEX_DIGITS[(value >> ((i - 1) * 4)) & 0xF];
+    }
+}
+
+uint64_t ParseHex(std::string_view text) {
+    uint64_t value = 0;
+    for (const char c : text) {
+        const size_t digit = HEX_DIGITS.find(c);
+        if (digit == std::string_view::npos) {
+            throw std::invalid_argument("Invalid search cursor");
+        }
+        value = (value << 4) | digit;
+    }
+    return value;
+}
+
+} // namespace
+
+std::string SearchCursor::ToString() const {
+    std::string text;
+    if (is_start_) {
+        return text;
+    }
+    uint64_t relevance_bits;
+    std::memcpy(&relevance_bits, &last_document_.relevance, sizeof(relevance_bits));
+    text.reserve(CURSOR_BYTES * 2);
+    AppendHex(text, relevance_bits, sizeof(double));
+    AppendHex(text, static_cast<uint32_t>(last_document_.rating), sizeof(int32_t));
+    AppendHex(text, static_cast<uint32_t>(last_document_.id), sizeof(int32_t));
+    AppendHex(text, generation_, sizeof(uint64_t));
+    return text;
+}
+
+SearchCursor SearchCursor::FromString(std::string_view text) {
+    if (text.empty()) {
+        return SearchCursor();
+    }
+    if (text.size() != CURSOR_BYTES * 2) {
+        throw std::invalid_argument("Invalid search cursor");
+    }
+    const uint64_t relevance_bits = ParseHex(text.substr(0, 16));
+    double relevance;
+    std::memcpy(&relevance, &relevance_bits, sizeof(relevance));
+    const auto rating = static_cast<int32_t>(static_cast<uint32_t>(ParseHex(text.substr(16, 8))));
+    const auto id = static_cast<int32_t>(static_cast<uint32_t>(ParseHex(text.substr(24, 8))));
+    return SearchCursor(Document(id, relevance, rating), ParseHex(text.substr(32, 16)));
+}
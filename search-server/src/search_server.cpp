@@ -1,111 +1,870 @@
 #include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <numeric>
+#include <unordered_map>
  
+#include "radix_sort.h"
 #include "search_server.h"
+
+namespace {
+
+template <typename T>
+void AppendRaw(std::vector<uint8_t>& out, const T* items, size_t count) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(items);
+    out.insert(out.end(), bytes, bytes + count * sizeof(T));
+}
+
+[[noreturn]] void ThrowCorruptedIndex(const std::string& reason) {
+    throw std::runtime_error("Corrupted index file: " + reason);
+}
+
+// Проверяет заголовок, границы секций и, если нужно, контрольную сумму
+const IndexFileHeader& CheckIndexFile(const MappedFile& file, bool verify_checksum) {
+    if (file.size() < sizeof(IndexFileHeader)) {
+        ThrowCorruptedIndex("file is too small");
+    }
+    const auto& header = *reinterpret_cast<const IndexFileHeader*>(file.data());
+    if (std::memcmp(header.magic, INDEX_FILE_MAGIC, sizeof(INDEX_FILE_MAGIC)) != 0) {
+        ThrowCorruptedIndex("bad magic");
+    }
+    if (header.version != INDEX_FILE_VERSION) {
+        throw std::runtime_error("Unsupported index file version " + std::to_string(header.version));
+    }
+    if (header.section_count != INDEX_SECTION_COUNT || header.file_size != file.size()) {
+        ThrowCorruptedIndex("bad header");
+    }
+    for (const IndexSectionInfo& section : header.sections) {
+        if (section.offset % INDEX_SECTION_ALIGNMENT != 0 || section.offset < sizeof(IndexFileHeader)
+            || section.offset > file.size() || section.size > file.size() - section.offset) {
+            ThrowCorruptedIndex("section out of bounds");
+        }
+    }
+    if (verify_checksum && header.checksum != ComputeIndexChecksum(file.data() + sizeof(IndexFileHeader), file.size() - sizeof(IndexFileHeader))) {
+        ThrowCorruptedIndex("checksum mismatch");
+    }
+    return header;
+}
+
+template <typename T>
+const T* GetSection(const MappedFile& file, IndexSection section, size_t& count) {
+    const IndexSectionInfo& info = reinterpret_cast<const IndexFileHeader*>(file.data())->sections[section];
+    if (info.size % sizeof(T) != 0) {
+        ThrowCorruptedIndex("bad section size");
+    }
+    count = info.size / sizeof(T);
+    return reinterpret_cast<const T*>(file.data() + info.offset);
+}
+
+// Проверяет таблицу границ строк: count + 1 неубывающих смещений внутри секции байтов
+void CheckStringOffsets(const uint64_t* offsets, size_t offset_count, size_t byte_count) {
+    if (offset_count == 0 || offsets[0] != 0 || offsets[offset_count - 1] > byte_count) {
+        ThrowCorruptedIndex("bad string offsets");
+    }
+    for (size_t i = 1; i < offset_count; ++i) {
+        if (offsets[i] < offsets[i - 1]) {
+            ThrowCorruptedIndex("bad string offsets");
+        }
+    }
+}
+
+std::set<std::string, std::less<>> ReadStopWords(const MappedFile& file, const IndexFileHeader&) {
+    size_t byte_count = 0;
+    size_t offset_count = 0;
+    const char* bytes = GetSection<char>(file, STOP_WORD_BYTES, byte_count);
+    const uint64_t* offsets = GetSection<uint64_t>(file, STOP_WORD_OFFSETS, offset_count);
+    CheckStringOffsets(offsets, offset_count, byte_count);
+    std::set<std::string, std::less<>> stop_words;
+    for (size_t i = 0; i + 1 < offset_count; ++i) {
+        stop_words.emplace(bytes + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+    return stop_words;
+}
+
+} // namespace
  
 SearchServer::SearchServer(const std::string& stop_words_text)
-    : SearchServer(SplitIntoWords(stop_words_text))
+    : SearchServer(Tokenizer().Tokenize(stop_words_text))
 {
 }
+
+SearchServer::SearchServer(std::shared_ptr<const MappedFile> index_file, bool verify)
+    : stop_words_(ReadStopWords(*index_file, CheckIndexFile(*index_file, verify)))
+    , index_file_(std::move(index_file))
+{
+    const MappedFile& file = *index_file_;
+
+    size_t term_byte_count = 0;
+    size_t term_offset_count = 0;
+    size_t sorted_term_count = 0;
+    const char* term_bytes = GetSection<char>(file, TERM_BYTES, term_byte_count);
+    const uint64_t* term_offsets = GetSection<uint64_t>(file, TERM_OFFSETS, term_offset_count);
+    const TermId* sorted_term_ids = GetSection<TermId>(file, SORTED_TERM_IDS, sorted_term_count);
+    CheckStringOffsets(term_offsets, term_offset_count, term_byte_count);
+    const size_t term_count = term_offset_count - 1;
+    if (sorted_term_count != term_count
+        || std::any_of(sorted_term_ids, sorted_term_ids + term_count, [term_count](TermId id) { return id >= term_count; })) {
+        ThrowCorruptedIndex("bad term index");
+    }
+    terms_.Map(term_bytes, term_offsets, sorted_term_ids, static_cast<TermId>(term_count));
+
+    // Записи списков и документов проверяются всегда: это O(терминов + документов),
+    // и по ним индекс находит данные в файле. Содержимое — номера документов
+    // в списках и термины документов — читается целиком только с verify
+    size_t document_count = 0;
+    size_t document_term_count = 0;
+    size_t document_id_count = 0;
+    mapped_documents_ = GetSection<IndexDocumentRecord>(file, DOCUMENTS, document_count);
+    mapped_document_terms_ = GetSection<DocumentTerm>(file, DOCUMENT_TERMS, document_term_count);
+    mapped_document_ids_ = GetSection<IndexDocumentId>(file, DOCUMENT_IDS, document_id_count);
+    mapped_document_ids_end_ = mapped_document_ids_ + document_id_count;
+    if (document_count > static_cast<size_t>(std::numeric_limits<int>::max()) || document_id_count > document_count) {
+        ThrowCorruptedIndex("bad document record");
+    }
+    mapped_document_count_ = static_cast<int>(document_count);
+    mapped_live_count_ = static_cast<int>(document_id_count);
+
+    size_t list_count = 0;
+    size_t block_count = 0;
+    size_t data_size = 0;
+    const auto* lists = GetSection<IndexPostingListRecord>(file, POSTING_LISTS, list_count);
+    const auto* blocks = GetSection<PostingList::BlockInfo>(file, POSTING_BLOCKS, block_count);
+    const uint8_t* data = GetSection<uint8_t>(file, POSTING_DATA, data_size);
+    if (list_count != term_count) {
+        ThrowCorruptedIndex("bad posting lists");
+    }
+    term_postings_.reserve(list_count);
+    term_stats_.resize(list_count);
+    for (size_t i = 0; i < list_count; ++i) {
+        const IndexPostingListRecord& list = lists[i];
+        if (list.first_block > block_count || list.block_count > block_count - list.first_block
+            || list.data_offset > data_size || list.data_size > data_size - list.data_offset
+            || (verify && !PostingList::IsValidMapping(blocks + list.first_block, list.block_count, data + list.data_offset,
+                   list.data_size, list.posting_count, static_cast<int>(document_count)))) {
+            ThrowCorruptedIndex("bad posting lists");
+        }
+        term_postings_.push_back(PostingList::Map(blocks + list.first_block, list.block_count,
+            data + list.data_offset, list.data_size, list.posting_count, list.max_term_freq));
+        term_stats_[i].document_count = list.posting_count;
+    }
+
+    documents_.Reserve(document_count);
+    size_t live_count = 0;
+    for (int ordinal = 0; ordinal < mapped_document_count_; ++ordinal) {
+        const IndexDocumentRecord& document = mapped_documents_[ordinal];
+        if (document.status < 0 || document.status > static_cast<int32_t>(DocumentStatus::REMOVED)
+            || document.first_term > document_term_count || document.term_count > document_term_count - document.first_term) {
+            ThrowCorruptedIndex("bad document record");
+        }
+        const DocumentTerm* terms = mapped_document_terms_ + document.first_term;
+        for (uint64_t i = 0; verify && i < document.term_count; ++i) {
+            if (terms[i].term_id >= term_count || (i > 0 && terms[i].term_id <= terms[i - 1].term_id)) {
+                ThrowCorruptedIndex("bad document terms");
+            }
+        }
+        documents_.Add(document.id, document.rating, static_cast<DocumentStatus>(document.status),
+            document.inv_word_count, document.is_removed != 0);
+        live_count += document.is_removed == 0;
+    }
+
+    if (verify) {
+        // Каждый живой документ ровно один раз и по возрастанию id
+        for (size_t i = 0; i < document_id_count; ++i) {
+            const IndexDocumentId& entry = mapped_document_ids_[i];
+            if (!IsLiveMappedId(entry) || documents_.GetId(entry.ordinal) != entry.id
+                || (i > 0 && entry.id <= mapped_document_ids_[i - 1].id)) {
+                ThrowCorruptedIndex("bad document ids");
+            }
+        }
+        if (document_id_count != live_count) {
+            ThrowCorruptedIndex("bad document ids");
+        }
+    }
+}
+
+SearchServer SearchServer::OpenIndex(const std::string& path, bool verify) {
+    return SearchServer(std::make_shared<const MappedFile>(path), verify);
+}
+
+void SearchServer::SaveIndex(const std::string& path) const {
+    std::vector<std::vector<uint8_t>> sections(INDEX_SECTION_COUNT);
+
+    std::vector<uint64_t> offsets{ 0 };
+    for (const std::string& word : stop_words_) {
+        AppendRaw(sections[STOP_WORD_BYTES], word.data(), word.size());
+        offsets.push_back(sections[STOP_WORD_BYTES].size());
+    }
+    AppendRaw(sections[STOP_WORD_OFFSETS], offsets.data(), offsets.size());
+
+    offsets.assign(1, 0);
+    std::vector<TermId> sorted_term_ids(terms_.size());
+    for (TermId term_id = 0; term_id < terms_.size(); ++term_id) {
+        const std::string_view term = terms_.GetTerm(term_id);
+        AppendRaw(sections[TERM_BYTES], term.data(), term.size());
+        offsets.push_back(sections[TERM_BYTES].size());
+        sorted_term_ids[term_id] = term_id;
+    }
+    std::sort(sorted_term_ids.begin(), sorted_term_ids.end(),
+        [this](TermId lhs, TermId rhs) { return terms_.GetTerm(lhs) < terms_.GetTerm(rhs); });
+    AppendRaw(sections[TERM_OFFSETS], offsets.data(), offsets.size());
+    AppendRaw(sections[SORTED_TERM_IDS], sorted_term_ids.data(), sorted_term_ids.size());
+
+    std::vector<PostingList::BlockInfo> blocks;
+    std::vector<uint8_t>& posting_data = sections[POSTING_DATA];
+    for (TermId term_id = 0; term_id < terms_.size(); ++term_id) {
+        IndexPostingListRecord list{};
+        list.first_block = blocks.size();
+        list.data_offset = posting_data.size();
+        if (term_id < term_postings_.size()) {
+            // В файл не попадают записи удалённых документов
+            PostingList compacted;
+            if (term_stats_[term_id].removed_count > 0) {
+                compacted = term_postings_[term_id];
+                compacted.Compact([this](int ordinal) { return documents_.IsRemoved(ordinal); },
+                    [this](const Posting& posting) { return posting.term_count * documents_.GetInvWordCount(posting.ordinal); });
+            }
+            const PostingList& postings = term_stats_[term_id].removed_count > 0 ? compacted : term_postings_[term_id];
+            postings.Export(blocks, posting_data);
+            list.posting_count = static_cast<uint32_t>(postings.size());
+            list.max_term_freq = postings.GetMaxTermFreq();
+        }
+        list.block_count = static_cast<uint32_t>(blocks.size() - list.first_block);
+        list.data_size = posting_data.size() - list.data_offset;
+        AppendRaw(sections[POSTING_LISTS], &list, 1);
+    }
+    AppendRaw(sections[POSTING_BLOCKS], blocks.data(), blocks.size());
+
+    uint64_t document_term_count = 0;
+    for (int ordinal = 0; ordinal < static_cast<int>(documents_.size()); ++ordinal) {
+        IndexDocumentRecord document{};
+        document.id = documents_.GetId(ordinal);
+        document.rating = documents_.GetRating(ordinal);
+        document.status = static_cast<int32_t>(documents_.GetStatus(ordinal));
+        document.is_removed = documents_.IsRemoved(ordinal);
+        document.inv_word_count = documents_.GetInvWordCount(ordinal);
+        document.first_term = document_term_count;
+        if (!document.is_removed) {
+            for (const DocumentTerm& term : GetDocumentTerms(ordinal)) {
+                // Через memset, чтобы в файл не попали байты выравнивания
+                DocumentTerm record;
+                std::memset(&record, 0, sizeof(record));
+                record.term_id = term.term_id;
+                record.term_freq = term.term_freq;
+                AppendRaw(sections[DOCUMENT_TERMS], &record, 1);
+                ++document.term_count;
+            }
+        }
+        document_term_count += document.term_count;
+        AppendRaw(sections[DOCUMENTS], &document, 1);
+    }
+    for (const int document_id : *this) {
+        const IndexDocumentId entry{ document_id, GetOrdinal(document_id) };
+        AppendRaw(sections[DOCUMENT_IDS], &entry, 1);
+    }
+
+    IndexFileHeader header{};
+    std::memcpy(header.magic, INDEX_FILE_MAGIC, sizeof(INDEX_FILE_MAGIC));
+    header.version = INDEX_FILE_VERSION;
+    header.section_count = INDEX_SECTION_COUNT;
+    uint64_t offset = sizeof(IndexFileHeader);
+    for (size_t i = 0; i < sections.size(); ++i) {
+        header.sections[i] = { offset, sections[i].size() };
+        sections[i].resize((sections[i].size() + INDEX_SECTION_ALIGNMENT - 1) / INDEX_SECTION_ALIGNMENT * INDEX_SECTION_ALIGNMENT, 0);
+        offset += sections[i].size();
+    }
+    header.file_size = offset;
+    // Секции выровнены на 8 байт, поэтому сумму можно считать по частям
+    header.checksum = INDEX_CHECKSUM_SEED;
+    for (const auto& section : sections) {
+        header.checksum = ComputeIndexChecksum(section.data(), section.size(), header.checksum);
+    }
+
+    // Файл пишется рядом под временным именем и подменяет path через rename.
+    // Процессы, отобразившие прежний файл, дочитывают его страницы: усечь файл
+    // на месте значило бы уронить их с SIGBUS
+    const size_t name_begin = path.find_last_of('/');
+    const std::string temporary_path = name_begin == std::string::npos
+        ? CreateUniqueFile(".", path + ".tmp", {})
+        : CreateUniqueFile(path.substr(0, name_begin), path.substr(name_begin + 1) + ".tmp", {});
+    std::ofstream out(temporary_path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& section : sections) {
+        out.write(reinterpret_cast<const char*>(section.data()), static_cast<std::streamsize>(section.size()));
+    }
+    out.close();
+    if (!out || std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+        std::remove(temporary_path.c_str());
+        throw std::runtime_error("Cannot write index file " + path);
+    }
+}
  
 void SearchServer::AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
-    if ((document_id < 0) || (documents_.count(document_id) > 0)) {
+    METRICS_SCOPED_TIMER("index.add_document");
+    if ((document_id < 0) || (FindOrdinal(document_id) >= 0)) {
         throw std::invalid_argument("Invalid document_id");
     }
-    const auto words = SplitIntoWordsNoStop(document);
-    
+    static thread_local std::vector<std::string_view> words;
+    SplitIntoWordsNoStop(document, words);
+
     const double inv_word_count = 1.0 / words.size();
+    std::map<TermId, uint32_t> term_counts;
     for (const std::string_view word : words) {
-        word_to_document_freqs_[std::string{word}][document_id] += inv_word_count;
-        document_to_word_freqs_[document_id][word] += inv_word_count;
+        ++term_counts[terms_.Intern(word)];
+    }
+    term_postings_.resize(terms_.size());
+    term_stats_.resize(terms_.size());
+
+    const int ordinal = static_cast<int>(documents_.size());
+    auto& document_terms = owned_document_terms_.emplace_back();
+    document_terms.reserve(term_counts.size());
+    for (const auto [term_id, term_count] : term_counts) {
+        const double term_freq = term_count * inv_word_count;
+        term_postings_[term_id].Add(ordinal, term_count, term_freq);
+        ++term_stats_[term_id].document_count;
+        document_terms.push_back({ term_id, term_freq });
     }
-    documents_.emplace(document_id, DocumentData{ ComputeAverageRating(ratings), status });
+    documents_.Add(document_id, ComputeAverageRating(ratings), status, inv_word_count);
+    document_ordinals_.emplace(document_id, ordinal);
     document_ids_.insert(document_id);
+    ++generation_;
+    METRICS_COUNTER_ADD("index.documents_added", 1);
 }
  
-std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-        return document_status == status;
-        });
+void SearchServer::AddDocuments(const std::vector<NewDocument>& documents) {
+    METRICS_SCOPED_TIMER("index.add_documents");
+    std::vector<int> new_ids;
+    new_ids.reserve(documents.size());
+    for (const NewDocument& document : documents) {
+        if (document.id < 0 || FindOrdinal(document.id) >= 0) {
+            throw std::invalid_argument("Invalid document_id");
+        }
+        new_ids.push_back(document.id);
+    }
+    std::sort(new_ids.begin(), new_ids.end());
+    if (std::adjacent_find(new_ids.begin(), new_ids.end()) != new_ids.end()) {
+        throw std::invalid_argument("Invalid document_id");
+    }
+
+    ThreadPool& pool = GetThreadPool();
+    const size_t document_count = documents.size();
+
+    // Разбор текстов. Исключение из некорректного текста вылетает здесь, до изменения индекса
+    struct ParsedDocument {
+        std::vector<std::string_view> words; // без повторов, в порядке первого вхождения
+        std::vector<uint32_t> counts;
+        std::vector<DocumentTerm> terms;
+        double inv_word_count;
+        int rating;
+    };
+    std::vector<ParsedDocument> parsed(document_count);
+    pool.ParallelFor(document_count, [&](size_t i) {
+        static thread_local std::vector<std::string_view> words;
+        SplitIntoWordsNoStop(documents[i].text, words);
+        ParsedDocument& document = parsed[i];
+        document.inv_word_count = 1.0 / words.size();
+        document.rating = ComputeAverageRating(documents[i].ratings);
+
+        std::vector<std::pair<std::string_view, uint32_t>> word_positions(words.size());
+        for (uint32_t position = 0; position < words.size(); ++position) {
+            word_positions[position] = { words[position], position };
+        }
+        std::sort(word_positions.begin(), word_positions.end());
+        std::vector<std::pair<uint32_t, uint32_t>> first_positions; // первая позиция слова, число вхождений
+        for (size_t begin = 0, end = 0; begin < word_positions.size(); begin = end) {
+            while (end < word_positions.size() && word_positions[end].first == word_positions[begin].first) {
+                ++end;
+            }
+            first_positions.emplace_back(word_positions[begin].second, static_cast<uint32_t>(end - begin));
+        }
+        std::sort(first_positions.begin(), first_positions.end());
+        for (const auto& [position, count] : first_positions) {
+            document.words.push_back(words[position]);
+            document.counts.push_back(count);
+        }
+    });
+
+    // Новые термины. Слова раскладываются по группам по хешу, и каждая группа
+    // находит первое вхождение своих слов. Идентификаторы раздаются в порядке
+    // первых вхождений — так же, как при добавлении документов по одному
+    const size_t part_count = pool.GetThreadCount() + 1;
+    const size_t shard_count = part_count * 4;
+    auto part_begin = [document_count, part_count](size_t part) {
+        return document_count * part / part_count;
+    };
+    std::vector<std::vector<std::pair<std::string_view, uint64_t>>> shard_words(part_count * shard_count);
+    pool.ParallelFor(part_count, [&](size_t part) {
+        for (size_t i = part_begin(part); i < part_begin(part + 1); ++i) {
+            for (size_t k = 0; k < parsed[i].words.size(); ++k) {
+                const std::string_view word = parsed[i].words[k];
+                if (terms_.Find(word) == TermDictionary::NO_TERM) {
+                    const size_t shard = std::hash<std::string_view>{}(word) % shard_count;
+                    shard_words[part * shard_count + shard].emplace_back(word, (static_cast<uint64_t>(i) << 32) | k);
+                }
+            }
+        }
+    });
+    std::vector<std::vector<std::pair<uint64_t, std::string_view>>> shard_new_terms(shard_count);
+    pool.ParallelFor(shard_count, [&](size_t shard) {
+        // Части перебираются по порядку, поэтому первая вставка слова и есть его первое вхождение
+        std::unordered_map<std::string_view, uint64_t> first_occurrences;
+        for (size_t part = 0; part < part_count; ++part) {
+            for (const auto& [word, occurrence] : shard_words[part * shard_count + shard]) {
+                first_occurrences.emplace(word, occurrence);
+            }
+        }
+        for (const auto& [word, occurrence] : first_occurrences) {
+            shard_new_terms[shard].emplace_back(occurrence, word);
+        }
+    });
+    shard_words.clear();
+    std::vector<std::pair<uint64_t, std::string_view>> new_terms;
+    for (auto& terms : shard_new_terms) {
+        new_terms.insert(new_terms.end(), terms.begin(), terms.end());
     }
+    std::sort(new_terms.begin(), new_terms.end());
+    for (const auto& [occurrence, word] : new_terms) {
+        terms_.Intern(word);
+    }
+    term_postings_.resize(terms_.size());
+    term_stats_.resize(terms_.size());
+
+    // Пары (термин, документ) в порядке документов
+    struct TermPosting {
+        TermId term_id;
+        int ordinal;
+        uint32_t term_count;
+    };
+    const int first_ordinal = static_cast<int>(documents_.size());
+    std::vector<size_t> posting_offsets(document_count + 1, 0);
+    for (size_t i = 0; i < document_count; ++i) {
+        posting_offsets[i + 1] = posting_offsets[i] + parsed[i].words.size();
+    }
+    std::vector<TermPosting> postings(posting_offsets.back());
+    pool.ParallelFor(document_count, [&](size_t i) {
+        ParsedDocument& document = parsed[i];
+        document.terms.reserve(document.words.size());
+        for (size_t k = 0; k < document.words.size(); ++k) {
+            const TermId term_id = terms_.Find(document.words[k]);
+            postings[posting_offsets[i] + k] = { term_id, first_ordinal + static_cast<int>(i), document.counts[k] };
+            document.terms.push_back({ term_id, document.counts[k] * document.inv_word_count });
+        }
+        std::sort(document.terms.begin(), document.terms.end(),
+            [](const DocumentTerm& lhs, const DocumentTerm& rhs) { return lhs.term_id < rhs.term_id; });
+    });
+
+    // Устойчивая сортировка по термину сохраняет возрастание номеров внутри
+    // термина, поэтому каждый список только дописывается. Части границами
+    // не разрезают термин, так что списки строятся независимо
+    ParallelRadixSort(pool, postings, static_cast<uint32_t>(terms_.size()), [](const TermPosting& posting) { return posting.term_id; });
+    const size_t build_part_count = part_count * 4;
+    std::vector<size_t> build_part_begins(build_part_count + 1, postings.size());
+    for (size_t part = 0; part < build_part_count; ++part) {
+        size_t position = postings.size() * part / build_part_count;
+        while (position > 0 && position < postings.size() && postings[position].term_id == postings[position - 1].term_id) {
+            ++position;
+        }
+        build_part_begins[part] = position;
+    }
+    pool.ParallelFor(build_part_count, [&](size_t part) {
+        for (size_t i = build_part_begins[part]; i < build_part_begins[part + 1]; ++i) {
+            const TermPosting& posting = postings[i];
+            const double term_freq = posting.term_count * parsed[posting.ordinal - first_ordinal].inv_word_count;
+            term_postings_[posting.term_id].Add(posting.ordinal, posting.term_count, term_freq);
+            ++term_stats_[posting.term_id].document_count;
+        }
+    });
+
+    documents_.Reserve(documents_.size() + document_count);
+    owned_document_terms_.reserve(owned_document_terms_.size() + document_count);
+    for (size_t i = 0; i < document_count; ++i) {
+        const int ordinal = first_ordinal + static_cast<int>(i);
+        documents_.Add(documents[i].id, parsed[i].rating, documents[i].status, parsed[i].inv_word_count);
+        owned_document_terms_.push_back(std::move(parsed[i].terms));
+        document_ordinals_.emplace_hint(document_ordinals_.end(), documents[i].id, ordinal);
+        document_ids_.insert(document_ids_.end(), documents[i].id);
+    }
+    ++generation_;
+    METRICS_COUNTER_ADD("index.documents_added", document_count);
+}
+ 
+std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query, DocumentStatus status, size_t top_k) const {
+    return FindTopDocuments(std::execution::seq, raw_query, status, top_k);
+}
  
 std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query) const {
     return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
 }
+
+PreparedQuery SearchServer::PrepareQuery(std::string_view raw_query) const {
+    auto text = std::make_shared<const std::string>(raw_query);
+    Query query = ParseQuery(*text);
+    return PreparedQuery(std::move(text), std::move(query));
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(const PreparedQuery& query, DocumentStatus status, size_t top_k) const {
+    return FindTopDocuments(std::execution::seq, query, status, top_k);
+}
+
+SearchPage SearchServer::FindPage(const PreparedQuery& query, const SearchCursor& cursor, size_t page_size, DocumentStatus status) const {
+    return FindPage(std::execution::seq, query, cursor, page_size, status);
+}
  
 int SearchServer::GetDocumentCount() const {
-    return documents_.size();
+    return static_cast<int>(document_ordinals_.size()) + mapped_live_count_;
+}
+
+uint32_t SearchServer::GetTermDocumentCount(std::string_view word) const {
+    const TermId term_id = terms_.Find(word);
+    return term_id == TermDictionary::NO_TERM ? 0 : term_stats_[term_id].document_count;
+}
+
+std::optional<TermStatistics> SearchServer::GetTermStatistics(std::string_view word) const {
+    const TermId term_id = terms_.Find(word);
+    if (term_id == TermDictionary::NO_TERM || term_stats_[term_id].document_count == 0) {
+        return std::nullopt;
+    }
+    return TermStatistics{ term_stats_[term_id].document_count, ComputeWordInverseDocumentFreq(term_id),
+        term_postings_[term_id].GetMaxTermFreq() };
+}
+
+void SearchServer::SetCorpusStatistics(const CorpusStatistics* statistics) {
+    corpus_statistics_ = statistics;
+    ++generation_;
+    // Поколения разных корпусов могут совпасть, поэтому кеши сбрасываются
+    for (const TermStats& stats : term_stats_) {
+        stats.inverse_document_freq.generation.store(CachedInverseDocumentFreq::NO_GENERATION, std::memory_order_relaxed);
+    }
+    if (query_cache_) {
+        const QueryCache empty_cache(*query_cache_);
+        query_cache_.emplace(empty_cache);
+    }
+}
+
+void SearchServer::SetQueryCacheCapacity(size_t capacity) {
+    query_cache_.reset();
+    if (capacity > 0) {
+        query_cache_.emplace(capacity);
+    }
+}
+
+void SearchServer::SetTokenizerOptions(const TokenizerOptions& options) {
+    tokenizer_ = Tokenizer(options);
+}
+
+QueryCacheStats SearchServer::GetQueryCacheStats() const {
+    return query_cache_ ? query_cache_->GetStats() : QueryCacheStats{};
 }
  
-std::set<int>::const_iterator SearchServer::begin() const {
-    return document_ids_.begin();
+void SearchServer::SetRankingMode(RankingMode mode) {
+    ranking_mode_ = mode;
 }
 
-std::set<int>::const_iterator SearchServer::end() const {
-    return document_ids_.end();
+RankingMode SearchServer::GetRankingMode() const {
+    return ranking_mode_;
 }
 
-const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const{
-    if (document_to_word_freqs_.count(document_id)) {
-        return document_to_word_freqs_.at(document_id);
+void SearchServer::SetQuerySyntax(QuerySyntax syntax) {
+    query_syntax_ = syntax;
+}
+
+QuerySyntax SearchServer::GetQuerySyntax() const {
+    return query_syntax_;
+}
+
+void SearchServer::SetThreadPool(ThreadPool& thread_pool) {
+    thread_pool_ = &thread_pool;
+}
+
+DocumentMask SearchServer::MakeDocumentMask() const {
+    DocumentMask mask;
+    mask.visible_ = documents_.GetLiveBitmap();
+    return mask;
+}
+
+void SearchServer::HideDocument(DocumentMask& mask, int document_id) const {
+    const int ordinal = GetOrdinal(document_id);
+    if (mask.visible_.Test(ordinal)) {
+        mask.visible_.Reset(ordinal);
+        ++mask.hidden_count_;
+    }
+}
+
+ThreadPool& SearchServer::GetThreadPool() const {
+    return thread_pool_ != nullptr ? *thread_pool_ : ThreadPool::GetDefault();
+}
+
+DocumentIdIterator SearchServer::begin() const {
+    return DocumentIdIterator(this, document_ids_.begin(), mapped_document_ids_);
+}
+
+DocumentIdIterator SearchServer::end() const {
+    return DocumentIdIterator(this, document_ids_.end(), mapped_document_ids_end_);
+}
+
+DocumentIdIterator::DocumentIdIterator(const SearchServer* server, std::set<int>::const_iterator owned, const IndexDocumentId* mapped)
+    : server_(server)
+    , owned_(owned)
+    , mapped_(mapped)
+{
+    SkipRemoved();
+}
+
+DocumentIdIterator::reference DocumentIdIterator::operator*() const {
+    return IsOwnedNext() ? *owned_ : mapped_->id;
+}
+
+DocumentIdIterator& DocumentIdIterator::operator++() {
+    if (IsOwnedNext()) {
+        ++owned_;
     }
     else {
+        ++mapped_;
+        SkipRemoved();
+    }
+    return *this;
+}
+
+DocumentIdIterator DocumentIdIterator::operator++(int) {
+    DocumentIdIterator previous = *this;
+    ++*this;
+    return previous;
+}
+
+void DocumentIdIterator::SkipRemoved() {
+    while (mapped_ != server_->mapped_document_ids_end_ && !server_->IsLiveMappedId(*mapped_)) {
+        ++mapped_;
+    }
+}
+
+// Живой id из файла и id из памяти не совпадают: повторно добавить можно только удалённый документ
+bool DocumentIdIterator::IsOwnedNext() const {
+    return mapped_ == server_->mapped_document_ids_end_
+        || (owned_ != server_->document_ids_.end() && *owned_ < mapped_->id);
+}
+
+const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const{
+    const int ordinal = FindOrdinal(document_id);
+    if (ordinal < 0) {
         static const std::map<std::string_view, double> empty_map ;
         return empty_map ;
     }
+    std::lock_guard lock(word_freqs_cache_.mutex);
+    const auto [it, inserted] = word_freqs_cache_.document_to_word_freqs.try_emplace(document_id);
+    if (inserted) {
+        for (const DocumentTerm& term : GetDocumentTerms(ordinal)) {
+            it->second.emplace(terms_.GetTerm(term.term_id), term.term_freq);
+        }
+    }
+    return it->second;
 }
 
 void SearchServer::RemoveDocument(int document_id){
-    if (document_ids_.find(document_id) == document_ids_.end()){
-        return;
+    RemoveDocument(std::execution::seq, document_id);
+}
+
+void SearchServer::RemoveDocuments(const std::vector<int>& document_ids) {
+    RemoveDocuments(std::execution::seq, document_ids);
+}
+
+void SearchServer::CompactIndex() {
+    if (static_cast<size_t>(GetDocumentCount()) < documents_.size()) {
+        RenumberDocuments(std::execution::par);
+    }
+}
+
+void SearchServer::MergeOrdinalsFrom(const SearchServer& source, const std::vector<int>& source_ordinals) {
+    if (stop_words_ != source.stop_words_) {
+        throw std::invalid_argument("Stop words of merged servers differ");
+    }
+    for (const int source_ordinal : source_ordinals) {
+        if (FindOrdinal(source.documents_.GetId(source_ordinal)) >= 0) {
+            throw std::invalid_argument("Invalid document_id");
+        }
+    }
+
+    // Новые номера идут подряд в порядке source, поэтому списки только наращиваются
+    std::vector<int> new_ordinals(source.documents_.size(), -1);
+    std::vector<TermId> new_term_ids(source.terms_.size(), TermDictionary::NO_TERM);
+    for (const int source_ordinal : source_ordinals) {
+        const int document_id = source.documents_.GetId(source_ordinal);
+        const int ordinal = static_cast<int>(documents_.size());
+        new_ordinals[source_ordinal] = ordinal;
+        auto& document_terms = owned_document_terms_.emplace_back();
+        for (const DocumentTerm& term : source.GetDocumentTerms(source_ordinal)) {
+            TermId& term_id = new_term_ids[term.term_id];
+            if (term_id == TermDictionary::NO_TERM) {
+                term_id = terms_.Intern(source.terms_.GetTerm(term.term_id));
+            }
+            document_terms.push_back({ term_id, term.term_freq });
+        }
+        std::sort(document_terms.begin(), document_terms.end(), [](const DocumentTerm& lhs, const DocumentTerm& rhs) {
+            return lhs.term_id < rhs.term_id;
+        });
+        documents_.Add(document_id, source.documents_.GetRating(source_ordinal), source.documents_.GetStatus(source_ordinal),
+            source.documents_.GetInvWordCount(source_ordinal));
+        document_ordinals_.emplace(document_id, ordinal);
+        document_ids_.insert(document_id);
     }
-    
-    std::string word_remove;
-    for (auto& [word, id_freq]: word_to_document_freqs_) {
-        if (id_freq.find(document_id) != id_freq.end()){
-            word_remove = word;
+    ++generation_;
+
+    term_postings_.resize(terms_.size());
+    term_stats_.resize(terms_.size());
+    for (TermId source_term_id = 0; source_term_id < new_term_ids.size(); ++source_term_id) {
+        const TermId term_id = new_term_ids[source_term_id];
+        if (term_id == TermDictionary::NO_TERM) {
+            continue;
+        }
+        for (const Posting& posting : source.term_postings_[source_term_id]) {
+            const int ordinal = new_ordinals[posting.ordinal];
+            if (ordinal < 0) {
+                continue;
+            }
+            term_postings_[term_id].Add(ordinal, posting.term_count, posting.term_count * documents_.GetInvWordCount(ordinal));
+            ++term_stats_[term_id].document_count;
         }
     }
-    
-    word_to_document_freqs_.erase(word_remove);
-    documents_.erase(document_id);
-    document_ids_.erase(document_id);
-    document_to_word_freqs_.erase(document_id); 
-    return;
 }
- 
-template<class ExecutionPolicy>
-std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(ExecutionPolicy&& policy, const std::string_view raw_query, int document_id) const {
-    if (document_to_word_freqs_.count(document_id) == 0) {
-        throw std::out_of_range("Такой id не существует");
+
+bool SearchServer::MarkDocumentRemoved(int document_id, std::vector<TermId>& removed_terms) {
+    const int ordinal = FindOrdinal(document_id);
+    if (ordinal < 0) {
+        return false;
+    }
+    for (const DocumentTerm& term : GetDocumentTerms(ordinal)) {
+        TermStats& stats = term_stats_[term.term_id];
+        --stats.document_count;
+        ++stats.removed_count;
+        removed_terms.push_back(term.term_id);
     }
-    
-    const auto query = ParseQuery(raw_query);
-	std::vector<std::string_view> matched_words;
+    documents_.MarkRemoved(ordinal);
+    if (document_ordinals_.erase(document_id) > 0) {
+        document_ids_.erase(document_id);
+    }
+    else {
+        --mapped_live_count_;
+    }
+    ++generation_;
+    if (ordinal >= mapped_document_count_) {
+        std::vector<DocumentTerm>().swap(owned_document_terms_[ordinal - mapped_document_count_]);
+    }
+    std::lock_guard lock(word_freqs_cache_.mutex);
+    word_freqs_cache_.document_to_word_freqs.erase(document_id);
+    return true;
+}
+
+bool SearchServer::NeedsCompaction(TermId term_id) const {
+    // Список сжимается, когда удалённые записи составляют больше четверти его длины.
+    // Так каждая запись перекодируется в среднем O(1) раз
+    static constexpr uint32_t MAX_REMOVED_SHARE = 4;
+    const TermStats& stats = term_stats_[term_id];
+    return stats.removed_count > 0
+        && (stats.document_count == 0 || stats.removed_count * MAX_REMOVED_SHARE > stats.document_count + stats.removed_count);
+}
+
+bool SearchServer::NeedsRenumbering() const {
+    // Номера переназначаются, когда удалённых слотов больше, чем живых документов.
+    // Перекодирование стоит O(записей живых документов), а до него удалено не меньше
+    // документов, чем живо, так что на удаление приходится O(терминов документа)
+    const size_t live_count = GetDocumentCount();
+    return documents_.size() - live_count > live_count;
+}
 
-    if (std::any_of(policy, //с seq в первый раз, скорость от чего то быстрее была, сейчс не заметно
-                query.minus_words.begin(),
-                query.minus_words.end(),
-                [&](const std::string_view word) { return word_to_document_freqs_.at(std::string(word)).count(document_id); }
-               )) {
-        return { matched_words, documents_.at(document_id).status };
+std::vector<int> SearchServer::PrepareRenumbering(std::vector<TermId>& term_ids) const {
+    std::vector<int> new_ordinals(documents_.size(), -1);
+    int first_removed = -1;
+    int next_ordinal = 0;
+    for (int ordinal = 0; ordinal < static_cast<int>(documents_.size()); ++ordinal) {
+        if (!documents_.IsRemoved(ordinal)) {
+            new_ordinals[ordinal] = next_ordinal++;
+        }
+        else if (first_removed < 0) {
+            first_removed = ordinal;
+        }
+    }
+    // Номера до первого удалённого не меняются, и списки, которые там заканчиваются,
+    // остаются как есть, в том числе отображённые из файла
+    for (TermId term_id = 0; term_id < term_postings_.size(); ++term_id) {
+        if (first_removed >= 0 && !term_postings_[term_id].LowerBound(first_removed).IsEnd()) {
+            term_ids.push_back(term_id);
+        }
+    }
+    return new_ordinals;
+}
+
+void SearchServer::RenumberPostingList(TermId term_id, const std::vector<int>& new_ordinals) {
+    PostingList& postings = term_postings_[term_id];
+    if (term_stats_[term_id].document_count == 0) {
+        postings = PostingList();
+    }
+    else {
+        postings.Renumber([&new_ordinals](int ordinal) { return new_ordinals[ordinal]; },
+            [this](const Posting& posting) { return posting.term_count * documents_.GetInvWordCount(posting.ordinal); });
     }
-    std::copy_if(policy,
-                 query.plus_words.begin(),
-                 query.plus_words.end(),
-                 std::back_inserter(matched_words),
-                 [&](const std::string_view word) { return word_to_document_freqs_.at(std::string(word)).count(document_id); }
-                );
-    
+    term_stats_[term_id].removed_count = 0;
+}
 
-	return { matched_words, documents_.at(document_id).status };
+void SearchServer::RenumberDocumentTable(const std::vector<int>& new_ordinals) {
+    const int first_removed = static_cast<int>(std::find(new_ordinals.begin(), new_ordinals.end(), -1) - new_ordinals.begin());
+    // Термины документов до первого удалённого остаются на месте, в том числе
+    // в отображённом файле; термины сдвигаемых отображённых документов копируются
+    const int mapped_document_count = std::min(mapped_document_count_, first_removed);
+    std::vector<std::vector<DocumentTerm>> owned_document_terms;
+    owned_document_terms.reserve(GetDocumentCount() - mapped_document_count);
+    DocumentTable documents;
+    documents.Reserve(GetDocumentCount());
+    for (int ordinal = 0; ordinal < static_cast<int>(new_ordinals.size()); ++ordinal) {
+        if (new_ordinals[ordinal] < 0) {
+            continue;
+        }
+        const int document_id = documents_.GetId(ordinal);
+        documents.Add(document_id, documents_.GetRating(ordinal), documents_.GetStatus(ordinal), documents_.GetInvWordCount(ordinal));
+        if (ordinal >= mapped_document_count_) {
+            owned_document_terms.push_back(std::move(owned_document_terms_[ordinal - mapped_document_count_]));
+        }
+        else if (ordinal >= mapped_document_count) {
+            const DocumentTermRange terms = GetDocumentTerms(ordinal);
+            owned_document_terms.emplace_back(terms.begin(), terms.end());
+        }
+        // Номера в файле больше не верны, так что id из файла переезжают в память
+        if (document_ordinals_.insert_or_assign(document_id, new_ordinals[ordinal]).second) {
+            document_ids_.insert(document_id);
+        }
+    }
+    documents_ = std::move(documents);
+    owned_document_terms_ = std::move(owned_document_terms);
+    mapped_document_count_ = mapped_document_count;
+    mapped_document_ids_ = nullptr;
+    mapped_document_ids_end_ = nullptr;
+    mapped_live_count_ = 0;
+    for (TermStats& stats : term_stats_) {
+        stats.removed_count = 0;
+    }
 }
 
+void SearchServer::CompactPostingList(TermId term_id) {
+    PostingList& postings = term_postings_[term_id];
+    if (term_stats_[term_id].document_count == 0) {
+        postings = PostingList();
+    }
+    else {
+        postings.Compact([this](int ordinal) { return documents_.IsRemoved(ordinal); },
+            [this](const Posting& posting) { return posting.term_count * documents_.GetInvWordCount(posting.ordinal); });
+    }
+    term_stats_[term_id].removed_count = 0;
+}
+ 
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const std::string_view raw_query, int document_id) const {
     return { SearchServer::MatchDocument(std::execution::seq, raw_query, document_id) };
 }
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const PreparedQuery& query, int document_id) const {
+    return MatchDocument(std::execution::seq, query, document_id);
+}
  
 bool SearchServer::IsStopWord(const std::string_view word) const {
-    return stop_words_.count(word) > 0;
+    return stop_word_lookup_.Contains(word);
 }
  
 bool SearchServer::IsValidWord(const std::string_view word) {
@@ -114,17 +873,16 @@ bool SearchServer::IsValidWord(const std::string_view word) {
         });
     }
  
-std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(const std::string_view text) const {
-    std::vector<std::string_view> words;
-    for (const std::string_view word : SplitIntoWords(text)) {
-        if (!IsValidWord(word)) {
-            throw std::invalid_argument("Word " + std::string{word} + " is invalid");
+void SearchServer::SplitIntoWordsNoStop(const std::string_view text, std::vector<std::string_view>& words) const {
+    words.clear();
+    for (const Token& token : tokenizer_.Tokenize(text)) {
+        if (token.has_control_chars) {
+            throw std::invalid_argument("Word " + std::string{token.word} + " is invalid");
         }
-        if (!IsStopWord(word)) {
-            words.push_back(word);
+        if (!IsStopWord(token.word)) {
+            words.push_back(token.word);
         }
     }
-    return words;
 }
  
 int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
@@ -134,39 +892,285 @@ int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
    return accumulate(ratings.begin(), ratings.end(), 0) / static_cast<int>(ratings.size());
 }
  
-SearchServer::QueryWord SearchServer::ParseQueryWord(const std::string_view text) const {
+SearchServer::QueryWord SearchServer::ParseQueryWord(const Token& token) const {
+    const std::string_view text = token.word;
     if (text.empty()) {
         throw std::invalid_argument("Query word is empty");
     }
     std::string_view word = text;
     bool is_minus = false;
+    bool is_required = false;
     if (word[0] == '-') {
         is_minus = true;
         word = word.substr(1);
     }
-    if (word.empty() || word[0] == '-' || !IsValidWord(word)) {
+    else if (query_syntax_ == QuerySyntax::REQUIRED_TERMS && word[0] == '+') {
+        is_required = true;
+        word = word.substr(1);
+    }
+    if (word.empty() || word[0] == '-' || (is_required && word[0] == '+') || token.has_control_chars) {
         throw std::invalid_argument("Query word " + std::string{text} + " is invalid");
     }
  
-    return { word, is_minus, IsStopWord(word) };
+    return { word, is_minus, is_required, IsStopWord(word) };
 }
  
-SearchServer::Query SearchServer::ParseQuery(const std::string_view text) const {
+std::string SearchServer::MakeQueryCacheKey(const Query& query, DocumentStatus status, size_t top_k) {
+    // Управляющие символы не встречаются в словах, поэтому разделители однозначны
+    std::string key = std::to_string(static_cast<int>(status)) + '\x01' + std::to_string(top_k);
+    for (const QueryTerms* terms : { &query.plus_terms, &query.minus_terms, &query.required_terms }) {
+        key += '\x01';
+        for (const QueryTerm& term : *terms) {
+            key += term.word;
+            key += '\x02';
+        }
+    }
+    return key;
+}
+
+Query SearchServer::ParseQuery(const std::string_view text) const {
+    Query result = SplitQuery(text);
+    ResolveQuery(result);
+    return result;
+}
+
+Query SearchServer::SplitQuery(const std::string_view text) const {
+    METRICS_SCOPED_TIMER("query.parse");
     Query result;
-    for (const std::string_view word : SplitIntoWords(text)) {
-        const auto query_word = ParseQueryWord(word);
+    for (const Token& token : tokenizer_.Tokenize(text)) {
+        const auto query_word = ParseQueryWord(token);
         if (!query_word.is_stop) {
             if (query_word.is_minus) {
-                result.minus_words.insert(query_word.data);
+                result.minus_terms.push_back({ query_word.data });
             }
             else {
-                result.plus_words.insert(query_word.data);
+                result.plus_terms.push_back({ query_word.data });
+                if (query_word.is_required) {
+                    result.required_terms.push_back({ query_word.data });
+                }
+            }
+        }
+    }
+    for (QueryTerms* terms : { &result.plus_terms, &result.minus_terms, &result.required_terms }) {
+        std::sort(terms->begin(), terms->end(),
+            [](const QueryTerm& lhs, const QueryTerm& rhs) { return lhs.word < rhs.word; });
+        terms->erase(std::unique(terms->begin(), terms->end(),
+            [](const QueryTerm& lhs, const QueryTerm& rhs) { return lhs.word == rhs.word; }), terms->end());
+    }
+    return result;
+}
+
+bool SearchServer::IsQueryResolved(const Query& query) const {
+    for (const QueryTerms* terms : { &query.plus_terms, &query.minus_terms, &query.required_terms }) {
+        for (const QueryTerm& term : *terms) {
+            if (term.term_id >= terms_.size() || terms_.GetTerm(term.term_id) != term.word) {
+                return false;
             }
         }
     }
-   return result;
+    return true;
+}
+
+void SearchServer::ResolveQuery(Query& query) const {
+    METRICS_SCOPED_TIMER("query.term_lookup");
+    for (QueryTerms* terms : { &query.plus_terms, &query.minus_terms, &query.required_terms }) {
+        for (QueryTerm& term : *terms) {
+            term.term_id = terms_.Find(term.word);
+        }
+    }
 }
  
-double SearchServer::ComputeWordInverseDocumentFreq(const std::string_view word) const {
-    return log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(std::string{word}).size());
+uint64_t SearchServer::GetStatisticsGeneration() const {
+    return corpus_statistics_ != nullptr ? corpus_statistics_->GetGeneration() | (uint64_t{ 1 } << 63) : generation_;
+}
+
+double SearchServer::ComputeWordInverseDocumentFreq(TermId term_id) const {
+    // Поколение меняется при каждом изменении набора документов, а с ним и число
+    // документов, и частоты слов. Пересчитываются только слова, встреченные в запросах
+    const uint64_t generation = GetStatisticsGeneration();
+    const TermStats& stats = term_stats_[term_id];
+    CachedInverseDocumentFreq& cached = stats.inverse_document_freq;
+    if (cached.generation.load(std::memory_order_acquire) != generation) {
+        double value = 0.0;
+        if (corpus_statistics_ != nullptr) {
+            // Документы слова могли быть удалены из других частей корпуса раньше, чем отсюда
+            const uint32_t document_count = corpus_statistics_->GetTermDocumentCount(terms_.GetTerm(term_id));
+            value = document_count > 0 ? log(corpus_statistics_->GetDocumentCount() * 1.0 / document_count) : 0.0;
+        }
+        else {
+            value = log(GetDocumentCount() * 1.0 / stats.document_count);
+        }
+        cached.value.store(value, std::memory_order_relaxed);
+        cached.generation.store(generation, std::memory_order_release);
+    }
+    return cached.value.load(std::memory_order_relaxed);
+}
+
+SearchServer::DocumentTermRange SearchServer::GetDocumentTerms(int ordinal) const {
+    if (ordinal < mapped_document_count_) {
+        const IndexDocumentRecord& document = mapped_documents_[ordinal];
+        const DocumentTerm* first = mapped_document_terms_ + document.first_term;
+        return { first, first + document.term_count };
+    }
+    const auto& terms = owned_document_terms_[ordinal - mapped_document_count_];
+    return { terms.data(), terms.data() + terms.size() };
+}
+
+int SearchServer::FindOrdinal(int document_id) const {
+    if (const auto it = document_ordinals_.find(document_id); it != document_ordinals_.end()) {
+        return it->second;
+    }
+    const IndexDocumentId* it = std::lower_bound(mapped_document_ids_, mapped_document_ids_end_, document_id,
+        [](const IndexDocumentId& entry, int id) { return entry.id < id; });
+    return it != mapped_document_ids_end_ && it->id == document_id && IsLiveMappedId(*it) ? it->ordinal : -1;
+}
+
+int SearchServer::GetOrdinal(int document_id) const {
+    const int ordinal = FindOrdinal(document_id);
+    if (ordinal < 0) {
+        throw std::out_of_range("Document " + std::to_string(document_id) + " not found");
+    }
+    return ordinal;
+}
+
+SearchServer::DocumentTermRange SearchServer::GetDocumentTermRange(int document_id) const {
+    return GetDocumentTerms(GetOrdinal(document_id));
+}
+
+std::string_view SearchServer::GetTerm(TermId term_id) const {
+    return terms_.GetTerm(term_id);
+}
+
+bool SearchServer::DocumentHasTerm(int document_id, TermId term_id) const {
+    if (term_id == TermDictionary::NO_TERM) {
+        return false;
+    }
+    const DocumentTermRange document_terms = GetDocumentTerms(GetOrdinal(document_id));
+    const auto it = std::lower_bound(document_terms.begin(), document_terms.end(), term_id,
+        [](const DocumentTerm& item, TermId id) { return item.term_id < id; });
+    return it != document_terms.end() && it->term_id == term_id;
+}
+
+std::vector<SearchServer::WeightedTerm> SearchServer::ResolvePlusWords(const Query& query) const {
+    std::vector<WeightedTerm> terms;
+    terms.reserve(query.plus_terms.size());
+    for (const QueryTerm& term : query.plus_terms) {
+        const TermId term_id = term.term_id;
+        if (term_id != TermDictionary::NO_TERM && term_stats_[term_id].document_count > 0) {
+            terms.push_back({ &term_postings_[term_id], ComputeWordInverseDocumentFreq(term_id) });
+        }
+    }
+    return terms;
+}
+
+size_t SearchServer::CountPlusPostings(const Query& query) const {
+    size_t posting_count = 0;
+    for (const QueryTerm& term : query.plus_terms) {
+        if (term.term_id != TermDictionary::NO_TERM) {
+            posting_count += term_postings_[term.term_id].size();
+        }
+    }
+    return posting_count;
+}
+
+ScoreAccumulator& SearchServer::GetThreadAccumulator() {
+    static thread_local ScoreAccumulator accumulator;
+    return accumulator;
+}
+
+bool SearchServer::PrepareCandidateFilter(const Query& query, ScoreAccumulator& accumulator) const {
+    METRICS_SCOPED_TIMER("query.minus_filter");
+    if (query.required_terms.empty()) {
+        for (const QueryTerm& term : query.minus_terms) {
+            const TermId term_id = term.term_id;
+            if (term_id != TermDictionary::NO_TERM) {
+                for (const Posting& posting : term_postings_[term_id]) {
+                    accumulator.Exclude(posting.ordinal);
+                }
+            }
+        }
+        return true;
+    }
+
+    std::vector<const PostingList*> required;
+    for (const QueryTerm& term : query.required_terms) {
+        const TermId term_id = term.term_id;
+        if (term_id == TermDictionary::NO_TERM || term_stats_[term_id].document_count == 0) {
+            return false;
+        }
+        required.push_back(&term_postings_[term_id]);
+    }
+    std::sort(required.begin(), required.end(),
+        [](const PostingList* lhs, const PostingList* rhs) { return lhs->size() < rhs->size(); });
+
+    static thread_local std::vector<int> candidates;
+    static thread_local std::vector<int> posting_ordinals;
+    // Короткий список кандидатов дешевле проверить по индексу пропусков,
+    // чем распаковывать длинный список документов целиком
+    static constexpr size_t LOOKUP_RATIO = 16;
+    auto apply = [](const PostingList& postings, bool keep_present) {
+        if (candidates.size() * LOOKUP_RATIO < postings.size()) {
+            candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                [&](int ordinal) { return postings.Contains(ordinal) != keep_present; }),
+                candidates.end());
+            return;
+        }
+        postings.DecodeOrdinals(posting_ordinals);
+        keep_present ? IntersectInPlace(candidates, posting_ordinals) : SubtractInPlace(candidates, posting_ordinals);
+    };
+
+    required.front()->DecodeOrdinals(candidates);
+    for (size_t i = 1; i < required.size() && !candidates.empty(); ++i) {
+        apply(*required[i], true);
+    }
+    for (const QueryTerm& term : query.minus_terms) {
+        const TermId term_id = term.term_id;
+        if (term_id != TermDictionary::NO_TERM && !candidates.empty()) {
+            apply(term_postings_[term_id], false);
+        }
+    }
+
+    accumulator.Restrict(candidates);
+    return !candidates.empty();
+}
+
+std::vector<Document> SearchServer::SelectTopDocuments(const ScoreAccumulator& accumulator, size_t top_k) const {
+    METRICS_SCOPED_TIMER("query.top_k");
+    TopDocuments top_documents(top_k);
+    for (const int ordinal : accumulator.GetTouched()) {
+        top_documents.Push({ documents_.GetId(ordinal), accumulator.GetScore(ordinal), documents_.GetRating(ordinal) });
+    }
+    return top_documents.Extract();
+}
+
+size_t SearchServer::CountScoringParts(const std::vector<WeightedTerm>& terms) const {
+    // На меньшем объёме части раздача задач пулу дороже самого счёта
+    static constexpr size_t MIN_POSTINGS_PER_PART = 1 << 14;
+    static constexpr size_t PARTS_PER_THREAD = 4;
+
+    size_t posting_count = 0;
+    for (const WeightedTerm& term : terms) {
+        posting_count += term.postings->size();
+    }
+    return std::min(posting_count / MIN_POSTINGS_PER_PART, (GetThreadPool().GetThreadCount() + 1) * PARTS_PER_THREAD);
+}
+
+SearchPage SearchServer::SelectPage(const ScoreAccumulator& accumulator, const SearchCursor& cursor, size_t page_size) const {
+    METRICS_SCOPED_TIMER("query.top_k");
+    // Лишний документ показывает, есть ли следующая страница
+    BasicTopDocuments<IsMoreRelevantStrict> top_documents(page_size + 1);
+    for (const int ordinal : accumulator.GetTouched()) {
+        const Document document(documents_.GetId(ordinal), accumulator.GetScore(ordinal), documents_.GetRating(ordinal));
+        if (cursor.IsStart() || IsMoreRelevantStrict(cursor.last_document_, document)) {
+            top_documents.Push(document);
+        }
+    }
+    SearchPage page;
+    page.documents = top_documents.Extract();
+    page.is_last = page.documents.size() <= page_size;
+    if (!page.is_last) {
+        page.documents.pop_back();
+    }
+    page.next = page.documents.empty() ? cursor : SearchCursor(page.documents.back(), GetStatisticsGeneration());
+    return page;
 }
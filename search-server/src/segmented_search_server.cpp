@@ -0,0 +1,268 @@
+#include "segmented_search_server.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+
+SegmentedSearchServer::SegmentedSearchServer(const std::string& stop_words_text, SegmentPolicy policy)
+    : SegmentedSearchServer(SplitIntoWords(stop_words_text), std::move(policy))
+{
+}
+
+SegmentedSearchServer::Segment::Segment(SearchServer&& index)
+    : index(std::move(index))
+{
+}
+
+SegmentedSearchServer::Segment::~Segment() {
+    if (!path.empty()) {
+        // Отображение живёт до конца разрушения index, но удалить имя файла можно уже сейчас
+        std::remove(path.c_str());
+    }
+}
+
+bool SegmentedSearchServer::Segment::IsDeleted(int document_id) const {
+    const auto it = std::lower_bound(document_ids.begin(), document_ids.end(), document_id);
+    return it != document_ids.end() && *it == document_id && is_deleted[it - document_ids.begin()];
+}
+
+void SegmentedSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    InstallMerge(false);
+    if (document_ids_.count(document_id) > 0) {
+        throw std::invalid_argument("Invalid document_id");
+    }
+    mutable_segment_->AddDocument(document_id, document, status, ratings);
+    document_ids_.insert(document_id);
+    ++generation_;
+    if (static_cast<size_t>(mutable_segment_->GetDocumentCount()) >= policy_.max_mutable_documents) {
+        SealMutableSegment();
+    }
+}
+
+void SegmentedSearchServer::RemoveDocument(int document_id) {
+    InstallMerge(false);
+    if (document_ids_.erase(document_id) == 0) {
+        return;
+    }
+    ++generation_;
+    for (const auto& segment : segments_) {
+        if (std::binary_search(segment->document_ids.begin(), segment->document_ids.end(), document_id)
+            && !segment->IsDeleted(document_id)) {
+            MarkDeleted(*segment, document_id);
+            return;
+        }
+    }
+    mutable_segment_->RemoveDocument(document_id);
+}
+
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status, size_t top_k) const {
+    return FindTopDocuments(raw_query, StatusFilter{ status }, top_k);
+}
+
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(std::string_view raw_query) const {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> SegmentedSearchServer::MatchDocument(std::string_view raw_query, int document_id) const {
+    if (document_ids_.count(document_id) > 0) {
+        for (const auto& segment : segments_) {
+            if (std::binary_search(segment->document_ids.begin(), segment->document_ids.end(), document_id)
+                && !segment->IsDeleted(document_id)) {
+                return segment->index.MatchDocument(raw_query, document_id);
+            }
+        }
+    }
+    // Отсутствующий документ изменяемый сегмент тоже не найдёт и бросит std::out_of_range
+    return mutable_segment_->MatchDocument(raw_query, document_id);
+}
+
+int SegmentedSearchServer::GetDocumentCount() const {
+    return static_cast<int>(document_ids_.size());
+}
+
+uint64_t SegmentedSearchServer::GetGeneration() const {
+    return generation_;
+}
+
+uint32_t SegmentedSearchServer::GetTermDocumentCount(std::string_view word) const {
+    uint32_t document_count = mutable_segment_->GetTermDocumentCount(word);
+    for (const auto& segment : segments_) {
+        document_count += segment->index.GetTermDocumentCount(word);
+        if (const auto it = segment->deleted_term_counts.find(word); it != segment->deleted_term_counts.end()) {
+            document_count -= it->second;
+        }
+    }
+    return document_count;
+}
+
+std::set<int>::const_iterator SegmentedSearchServer::begin() const {
+    return document_ids_.begin();
+}
+
+std::set<int>::const_iterator SegmentedSearchServer::end() const {
+    return document_ids_.end();
+}
+
+size_t SegmentedSearchServer::GetSegmentCount() const {
+    return segments_.size();
+}
+
+void SegmentedSearchServer::Flush() {
+    InstallMerge(false);
+    if (mutable_segment_->GetDocumentCount() > 0) {
+        SealMutableSegment();
+    }
+}
+
+void SegmentedSearchServer::WaitForMerges() {
+    InstallMerge(true);
+}
+
+void SegmentedSearchServer::SetRankingMode(RankingMode mode) {
+    ranking_mode_ = mode;
+    mutable_segment_->SetRankingMode(mode);
+    for (const auto& segment : segments_) {
+        segment->index.SetRankingMode(mode);
+    }
+}
+
+void SegmentedSearchServer::SetQuerySyntax(QuerySyntax syntax) {
+    query_syntax_ = syntax;
+    mutable_segment_->SetQuerySyntax(syntax);
+}
+
+std::shared_ptr<SegmentedSearchServer::Segment> SegmentedSearchServer::MakeSegment(SearchServer&& index, const std::string& directory) {
+    std::shared_ptr<Segment> segment;
+    if (directory.empty()) {
+        segment = std::make_shared<Segment>(std::move(index));
+    }
+    else {
+        // Имя занимается через mkstemps, так что другой сервер с тем же каталогом,
+        // в том числе в другом процессе или после перезапуска, не перезапишет файл
+        // и не удалит его вместе со своим сегментом. SaveIndex подменяет пустой
+        // файл готовым через rename
+        const std::string path = CreateUniqueFile(directory, "segment_", ".idx");
+        try {
+            index.SaveIndex(path);
+            segment = std::make_shared<Segment>(SearchServer::OpenIndex(path));
+        }
+        catch (...) {
+            std::remove(path.c_str());
+            throw;
+        }
+        segment->path = path;
+    }
+    segment->document_ids.assign(segment->index.begin(), segment->index.end());
+    segment->is_deleted.assign(segment->document_ids.size(), false);
+    segment->visible = segment->index.MakeDocumentMask();
+    return segment;
+}
+
+std::shared_ptr<SegmentedSearchServer::Segment> SegmentedSearchServer::MergeSegments(
+    const std::set<std::string, std::less<>>& stop_words,
+    const std::vector<std::shared_ptr<Segment>>& inputs,
+    const std::vector<std::vector<bool>>& deleted_snapshots,
+    const std::string& directory) {
+    SearchServer merged(stop_words);
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        const Segment& input = *inputs[i];
+        const std::vector<bool>& is_deleted = deleted_snapshots[i];
+        merged.MergeFrom(input.index, [&input, &is_deleted](int document_id) {
+            const auto it = std::lower_bound(input.document_ids.begin(), input.document_ids.end(), document_id);
+            return !is_deleted[it - input.document_ids.begin()];
+        });
+    }
+    return MakeSegment(std::move(merged), directory);
+}
+
+void SegmentedSearchServer::ResetMutableSegment() {
+    mutable_segment_.emplace(stop_words_);
+    mutable_segment_->SetCorpusStatistics(this);
+    mutable_segment_->SetRankingMode(ranking_mode_);
+    mutable_segment_->SetQuerySyntax(query_syntax_);
+}
+
+void SegmentedSearchServer::MarkDeleted(Segment& segment, int document_id) {
+    const auto it = std::lower_bound(segment.document_ids.begin(), segment.document_ids.end(), document_id);
+    segment.is_deleted[it - segment.document_ids.begin()] = true;
+    ++segment.deleted_count;
+    segment.index.HideDocument(segment.visible, document_id);
+    // GetWordFrequencies здесь не годится: он кеширует словарь частот каждого
+    // документа, и память росла бы как раз с удалёнными документами
+    for (const DocumentTerm& term : segment.index.GetDocumentTermRange(document_id)) {
+        ++segment.deleted_term_counts[segment.index.GetTerm(term.term_id)];
+    }
+}
+
+void SegmentedSearchServer::SealMutableSegment() {
+    // Удалённые из изменяемого сегмента документы в запечатанный не переносятся
+    SearchServer sealed(stop_words_);
+    sealed.MergeFrom(*mutable_segment_, [](int) { return true; });
+    segments_.push_back(MakeSegment(std::move(sealed), {}));
+    segments_.back()->index.SetCorpusStatistics(this);
+    segments_.back()->index.SetRankingMode(ranking_mode_);
+    ResetMutableSegment();
+    ScheduleMerge();
+}
+
+void SegmentedSearchServer::InstallMerge(bool wait) {
+    if (!pending_merge_) {
+        return;
+    }
+    PendingMerge& merge = *pending_merge_;
+    if (!wait && merge.result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return;
+    }
+    std::shared_ptr<Segment> merged;
+    try {
+        merged = merge.result.get();
+    }
+    catch (...) {
+        // Входы остаются на месте, индекс не меняется
+        pending_merge_.reset();
+        throw;
+    }
+
+    // Документы, удалённые из входов во время слияния, удаляются из результата
+    for (size_t i = 0; i < merge.inputs.size(); ++i) {
+        const Segment& input = *merge.inputs[i];
+        for (size_t position = 0; position < input.document_ids.size(); ++position) {
+            if (input.is_deleted[position] && !merge.deleted_snapshots[i][position]) {
+                MarkDeleted(*merged, input.document_ids[position]);
+            }
+        }
+    }
+    merged->index.SetCorpusStatistics(this);
+    merged->index.SetRankingMode(ranking_mode_);
+
+    segments_.erase(std::remove_if(segments_.begin(), segments_.end(), [&merge](const auto& segment) {
+        return std::find(merge.inputs.begin(), merge.inputs.end(), segment) != merge.inputs.end();
+    }), segments_.end());
+    segments_.push_back(std::move(merged));
+    pending_merge_.reset();
+    ScheduleMerge();
+}
+
+void SegmentedSearchServer::ScheduleMerge() {
+    if (pending_merge_ || segments_.size() <= policy_.max_segment_count) {
+        return;
+    }
+    std::vector<std::shared_ptr<Segment>> inputs = segments_;
+    const auto live_count = [](const std::shared_ptr<Segment>& segment) {
+        return segment->document_ids.size() - segment->deleted_count;
+    };
+    const size_t input_count = std::clamp<size_t>(policy_.merge_factor, 2, inputs.size());
+    std::partial_sort(inputs.begin(), inputs.begin() + input_count, inputs.end(),
+        [&live_count](const auto& lhs, const auto& rhs) { return live_count(lhs) < live_count(rhs); });
+    inputs.resize(input_count);
+
+    PendingMerge& merge = pending_merge_.emplace();
+    merge.inputs = std::move(inputs);
+    for (const auto& input : merge.inputs) {
+        merge.deleted_snapshots.push_back(input->is_deleted);
+    }
+    // Входы и снимки живут в pending_merge_, пока слияние не подключено
+    merge.result = std::async(std::launch::async, &SegmentedSearchServer::MergeSegments,
+        std::cref(stop_words_), std::cref(merge.inputs), std::cref(merge.deleted_snapshots), policy_.directory);
+}
@@ -0,0 +1,165 @@
+#include "sharded_search_server.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+ShardedSearchServer::ShardedSearchServer(const std::string& stop_words_text, ShardingOptions options)
+    : ShardedSearchServer(SplitIntoWords(stop_words_text), std::move(options))
+{
+}
+
+void ShardedSearchServer::InitShards(const std::set<std::string, std::less<>>& stop_words) {
+    if (options_.shard_count == 0) {
+        throw std::invalid_argument("Invalid shard count");
+    }
+    if (!options_.range_bounds.empty()
+        && (options_.range_bounds.size() != options_.shard_count - 1
+            || std::adjacent_find(options_.range_bounds.begin(), options_.range_bounds.end(), std::greater_equal<int>()) != options_.range_bounds.end())) {
+        throw std::invalid_argument("Invalid shard range bounds");
+    }
+    shards_.reserve(options_.shard_count);
+    for (size_t i = 0; i < options_.shard_count; ++i) {
+        shards_.emplace_back(stop_words);
+        shards_.back().SetCorpusStatistics(this);
+    }
+}
+
+void ShardedSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    // Повторный id попадёт в тот же шард, и тот его отвергнет
+    shards_[GetShardIndex(document_id)].AddDocument(document_id, document, status, ratings);
+    ++generation_;
+}
+
+void ShardedSearchServer::AddDocuments(const std::vector<NewDocument>& documents) {
+    // Поколение растёт заранее: при ошибке шарды успевают измениться и откатиться
+    ++generation_;
+    std::vector<std::vector<NewDocument>> parts(shards_.size());
+    for (const NewDocument& document : documents) {
+        parts[GetShardIndex(document.id)].push_back(document);
+    }
+    // Флаг пишет только задача своего шарда, а читается он после ParallelFor
+    std::vector<char> is_added(shards_.size(), false);
+    try {
+        GetThreadPool().ParallelFor(shards_.size(), [&](size_t i) {
+            if (!parts[i].empty()) {
+                shards_[i].AddDocuments(parts[i]);
+                is_added[i] = true;
+            }
+        });
+    }
+    catch (...) {
+        // Шард с ошибкой остался прежним, из остальных пачка удаляется
+        for (size_t i = 0; i < shards_.size(); ++i) {
+            if (is_added[i]) {
+                std::vector<int> document_ids;
+                document_ids.reserve(parts[i].size());
+                for (const NewDocument& document : parts[i]) {
+                    document_ids.push_back(document.id);
+                }
+                shards_[i].RemoveDocuments(document_ids);
+            }
+        }
+        throw;
+    }
+}
+
+void ShardedSearchServer::RemoveDocument(int document_id) {
+    RemoveDocument(std::execution::seq, document_id);
+}
+
+void ShardedSearchServer::RemoveDocuments(const std::vector<int>& document_ids) {
+    RemoveDocuments(std::execution::seq, document_ids);
+}
+
+PreparedQuery ShardedSearchServer::PrepareQuery(std::string_view raw_query) const {
+    return shards_.front().PrepareQuery(raw_query);
+}
+
+std::vector<Document> ShardedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status, size_t top_k) const {
+    return FindTopDocuments(std::execution::seq, raw_query, status, top_k);
+}
+
+std::vector<Document> ShardedSearchServer::FindTopDocuments(std::string_view raw_query) const {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+std::vector<Document> ShardedSearchServer::FindTopDocuments(const PreparedQuery& query, DocumentStatus status, size_t top_k) const {
+    return FindTopDocuments(std::execution::seq, query, status, top_k);
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> ShardedSearchServer::MatchDocument(std::string_view raw_query, int document_id) const {
+    // Документа нет — шард бросит std::out_of_range
+    return shards_[GetShardIndex(document_id)].MatchDocument(raw_query, document_id);
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> ShardedSearchServer::MatchDocument(const PreparedQuery& query, int document_id) const {
+    return shards_[GetShardIndex(document_id)].MatchDocument(query, document_id);
+}
+
+int ShardedSearchServer::GetDocumentCount() const {
+    int document_count = 0;
+    for (const SearchServer& shard : shards_) {
+        document_count += shard.GetDocumentCount();
+    }
+    return document_count;
+}
+
+uint32_t ShardedSearchServer::GetTermDocumentCount(std::string_view word) const {
+    uint32_t document_count = 0;
+    for (const SearchServer& shard : shards_) {
+        document_count += shard.GetTermDocumentCount(word);
+    }
+    return document_count;
+}
+
+uint64_t ShardedSearchServer::GetGeneration() const {
+    return generation_;
+}
+
+size_t ShardedSearchServer::GetShardCount() const {
+    return shards_.size();
+}
+
+size_t ShardedSearchServer::GetShardIndex(int document_id) const {
+    if (!options_.range_bounds.empty()) {
+        return std::upper_bound(options_.range_bounds.begin(), options_.range_bounds.end(), document_id)
+            - options_.range_bounds.begin();
+    }
+    // Хеш Фибоначчи: подряд идущие id расходятся по шардам равномерно
+    const uint64_t hash = static_cast<uint32_t>(document_id) * 0x9E3779B97F4A7C15;
+    return static_cast<size_t>((hash >> 32) % shards_.size());
+}
+
+const SearchServer& ShardedSearchServer::GetShard(size_t shard_index) const {
+    return shards_.at(shard_index);
+}
+
+void ShardedSearchServer::SetRankingMode(RankingMode mode) {
+    for (SearchServer& shard : shards_) {
+        shard.SetRankingMode(mode);
+    }
+}
+
+void ShardedSearchServer::SetQuerySyntax(QuerySyntax syntax) {
+    for (SearchServer& shard : shards_) {
+        shard.SetQuerySyntax(syntax);
+    }
+}
+
+void ShardedSearchServer::SetThreadPool(ThreadPool& thread_pool) {
+    for (SearchServer& shard : shards_) {
+        shard.SetThreadPool(thread_pool);
+    }
+}
+
+ThreadPool& ShardedSearchServer::GetThreadPool() const {
+    return shards_.front().GetThreadPool();
+}
+
+std::vector<std::vector<int>> ShardedSearchServer::SplitByShard(const std::vector<int>& document_ids) const {
+    std::vector<std::vector<int>> parts(shards_.size());
+    for (const int document_id : document_ids) {
+        parts[GetShardIndex(document_id)].push_back(document_id);
+    }
+    return parts;
+}
@@ -0,0 +1,150 @@
+#include "sorted_set_ops.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+#if defined(__AVX2__)
+
+#define SORTED_SET_OPS_SIMD
+constexpr size_t SIMD_WIDTH = 8;
+
+// Бит k выставлен, если lhs[k] совпадает с каким-нибудь из rhs[0..7]
+unsigned MatchMask(const int* lhs, const int* rhs) {
+    const __m256i left = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs));
+    __m256i right = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs));
+    const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+    __m256i matches = _mm256_cmpeq_epi32(left, right);
+    for (int i = 1; i < 8; ++i) {
+        right = _mm256_permutevar8x32_epi32(right, rotate);
+        matches = _mm256_or_si256(matches, _mm256_cmpeq_epi32(left, right));
+    }
+    return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(matches)));
+}
+
+#elif defined(__SSE2__)
+
+#define SORTED_SET_OPS_SIMD
+constexpr size_t SIMD_WIDTH = 4;
+
+unsigned MatchMask(const int* lhs, const int* rhs) {
+    const __m128i left = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs));
+    const __m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs));
+    __m128i matches = _mm_cmpeq_epi32(left, right);
+    matches = _mm_or_si128(matches, _mm_cmpeq_epi32(left, _mm_shuffle_epi32(right, _MM_SHUFFLE(0, 3, 2, 1))));
+    matches = _mm_or_si128(matches, _mm_cmpeq_epi32(left, _mm_shuffle_epi32(right, _MM_SHUFFLE(1, 0, 3, 2))));
+    matches = _mm_or_si128(matches, _mm_cmpeq_epi32(left, _mm_shuffle_epi32(right, _MM_SHUFFLE(2, 1, 0, 3))));
+    return static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(matches)));
+}
+
+#endif
+
+} // namespace
+
+size_t IntersectSorted(const int* lhs, size_t lhs_size, const int* rhs, size_t rhs_size, int* out) {
+    size_t i = 0;
+    size_t j = 0;
+    size_t k = 0;
+#ifdef SORTED_SET_OPS_SIMD
+    while (i + SIMD_WIDTH <= lhs_size && j + SIMD_WIDTH <= rhs_size) {
+        for (unsigned mask = MatchMask(lhs + i, rhs + j); mask != 0; mask &= mask - 1) {
+            out[k++] = lhs[i + __builtin_ctz(mask)];
+        }
+        const int lhs_max = lhs[i + SIMD_WIDTH - 1];
+        const int rhs_max = rhs[j + SIMD_WIDTH - 1];
+        if (lhs_max <= rhs_max) {
+            i += SIMD_WIDTH;
+        }
+        if (rhs_max <= lhs_max) {
+            j += SIMD_WIDTH;
+        }
+    }
+#endif
+    while (i < lhs_size && j < rhs_size) {
+        if (lhs[i] < rhs[j]) {
+            ++i;
+        }
+        else if (rhs[j] < lhs[i]) {
+            ++j;
+        }
+        else {
+            out[k++] = lhs[i++];
+            ++j;
+        }
+    }
+    return k;
+}
+
+size_t DifferenceSorted(const int* lhs, size_t lhs_size, const int* rhs, size_t rhs_size, int* out) {
+    size_t i = 0;
+    size_t j = 0;
+    size_t k = 0;
+    // Элементы текущего блока lhs, уже найденные в пройденных блоках rhs
+    unsigned matched = 0;
+#ifdef SORTED_SET_OPS_SIMD
+    constexpr unsigned FULL_MASK = (1u << SIMD_WIDTH) - 1;
+    while (i + SIMD_WIDTH <= lhs_size && j + SIMD_WIDTH <= rhs_size) {
+        matched |= MatchMask(lhs + i, rhs + j);
+        const int lhs_max = lhs[i + SIMD_WIDTH - 1];
+        const int rhs_max = rhs[j + SIMD_WIDTH - 1];
+        if (lhs_max <= rhs_max) {
+            for (unsigned keep = ~matched & FULL_MASK; keep != 0; keep &= keep - 1) {
+                out[k++] = lhs[i + __builtin_ctz(keep)];
+            }
+            i += SIMD_WIDTH;
+            matched = 0;
+        }
+        if (rhs_max <= lhs_max) {
+            j += SIMD_WIDTH;
+        }
+    }
+#endif
+    for (size_t first = i; i < lhs_size; ++i) {
+        if (i - first < 32 && (matched >> (i - first)) & 1) {
+            continue;
+        }
+        while (j < rhs_size && rhs[j] < lhs[i]) {
+            ++j;
+        }
+        if (j == rhs_size || rhs[j] != lhs[i]) {
+            out[k++] = lhs[i];
+        }
+    }
+    return k;
+}
+
+size_t UnionSorted(const int* lhs, size_t lhs_size, const int* rhs, size_t rhs_size, int* out) {
+    size_t i = 0;
+    size_t j = 0;
+    size_t k = 0;
+    while (i < lhs_size && j < rhs_size) {
+        const int left = lhs[i];
+        const int right = rhs[j];
+        out[k++] = left < right ? left : right;
+        i += left <= right;
+        j += right <= left;
+    }
+    while (i < lhs_size) {
+        out[k++] = lhs[i++];
+    }
+    while (j < rhs_size) {
+        out[k++] = rhs[j++];
+    }
+    return k;
+}
+
+void IntersectInPlace(std::vector<int>& ids, const std::vector<int>& other) {
+    ids.resize(IntersectSorted(ids.data(), ids.size(), other.data(), other.size(), ids.data()));
+}
+
+void SubtractInPlace(std::vector<int>& ids, const std::vector<int>& other) {
+    ids.resize(DifferenceSorted(ids.data(), ids.size(), other.data(), other.size(), ids.data()));
+}
+
+std::vector<int> UnionSorted(const std::vector<int>& lhs, const std::vector<int>& rhs) {
+    std::vector<int> result(lhs.size() + rhs.size());
+    result.resize(UnionSorted(lhs.data(), lhs.size(), rhs.data(), rhs.size(), result.data()));
+    return result;
+}
@@ -0,0 +1,30 @@
+#include "string_arena.h"
+
+#include <cstring>
+
+std::string_view StringArena::Store(std::string_view text) {
+    // Пустой строке не нужна память, а position_ до первого куска — nullptr,
+    // и memcpy в него недопустим даже нулевой длины
+    if (text.empty()) {
+        return {};
+    }
+    if (text.size() > remaining_) {
+        // Строка длиннее куска получает собственный кусок; текущий при этом
+        // не бросается, если в нём остаётся место для следующих строк
+        if (text.size() > CHUNK_SIZE / 4) {
+            auto& chunk = chunks_.emplace_back(new char[text.size()]);
+            allocated_ += text.size();
+            std::memcpy(chunk.get(), text.data(), text.size());
+            return { chunk.get(), text.size() };
+        }
+        chunks_.emplace_back(new char[CHUNK_SIZE]);
+        position_ = chunks_.back().get();
+        remaining_ = CHUNK_SIZE;
+        allocated_ += CHUNK_SIZE;
+    }
+    char* stored = position_;
+    std::memcpy(stored, text.data(), text.size());
+    position_ += text.size();
+    remaining_ -= text.size();
+    return { stored, text.size() };
+}
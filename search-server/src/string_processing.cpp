@@ -1,16 +1,175 @@
 #include "string_processing.h"
- 
-std::vector<std::string_view> SplitIntoWords(std::string_view str) {
-   std::vector<std::string_view> result;
-    const int64_t pos_end = str.npos;
-    while (true) {
-        int64_t space = str.find(' ');
-        result.push_back(space == pos_end ? str : str.substr(0, space));
-        if (space == pos_end) {
-            break;
-        } else {
-            str.remove_prefix(space + 1);
+
+#include <algorithm>
+
+#if defined(__AVX2__)
+#define TOKENIZER_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#define TOKENIZER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+bool IsControlChar(char c) {
+    return c >= '\0' && c < ' ';
+}
+
+int CountTrailingZeros(uint64_t bits) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(bits);
+#else
+    int count = 0;
+    for (; (bits & 1) == 0; bits >>= 1) {
+        ++count;
+    }
+    return count;
+#endif
+}
+
+// Биты позиций с from включительно
+uint64_t BitsFrom(size_t from) {
+    return from >= 64 ? 0 : ~uint64_t{ 0 } << from;
+}
+
+} // namespace
+
+Tokenizer::Tokenizer(const TokenizerOptions& options)
+    : skip_empty_words_(options.skip_empty_words) {
+    for (const char c : options.separators) {
+        const auto index = static_cast<unsigned char>(c);
+        if (is_separator_[index]) {
+            continue;
         }
+        is_separator_[index] = true;
+        if (vector_separator_count_ < MAX_VECTOR_SEPARATORS) {
+            vector_separators_[vector_separator_count_] = c;
+        }
+        ++vector_separator_count_;
+    }
+    if (vector_separator_count_ > MAX_VECTOR_SEPARATORS) {
+        vector_separator_count_ = 0;
+    }
+}
+
+TokenRange Tokenizer::Tokenize(std::string_view text) const {
+    return TokenRange(this, text);
+}
+
+void Tokenizer::Tokenize(std::string_view text, std::vector<Token>& tokens) const {
+    tokens.clear();
+    for (const Token& token : Tokenize(text)) {
+        tokens.push_back(token);
+    }
+}
+
+void Tokenizer::ClassifyChunk(const char* data, size_t size, uint64_t& separators, uint64_t& control_chars) const {
+    separators = 0;
+    control_chars = 0;
+#if defined(TOKENIZER_AVX2) || defined(TOKENIZER_SSE2)
+    if (size == CHUNK_SIZE && vector_separator_count_ > 0) {
+#if defined(TOKENIZER_AVX2)
+        using Vector = __m256i;
+        static constexpr size_t VECTOR_SIZE = 32;
+        const auto load = [](const char* p) { return _mm256_loadu_si256(reinterpret_cast<const Vector*>(p)); };
+        const auto splat = [](char c) { return _mm256_set1_epi8(c); };
+        const auto equal = [](Vector a, Vector b) { return _mm256_cmpeq_epi8(a, b); };
+        const auto greater = [](Vector a, Vector b) { return _mm256_cmpgt_epi8(a, b); };
+        const auto bit_or = [](Vector a, Vector b) { return _mm256_or_si256(a, b); };
+        const auto bit_and_not = [](Vector a, Vector b) { return _mm256_andnot_si256(a, b); };
+        const auto bit_and = [](Vector a, Vector b) { return _mm256_and_si256(a, b); };
+        const auto zero = [] { return _mm256_setzero_si256(); };
+        const auto mask = [](Vector a) { return static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(a))); };
+#else
+        using Vector = __m128i;
+        static constexpr size_t VECTOR_SIZE = 16;
+        const auto load = [](const char* p) { return _mm_loadu_si128(reinterpret_cast<const Vector*>(p)); };
+        const auto splat = [](char c) { return _mm_set1_epi8(c); };
+        const auto equal = [](Vector a, Vector b) { return _mm_cmpeq_epi8(a, b); };
+        const auto greater = [](Vector a, Vector b) { return _mm_cmpgt_epi8(a, b); };
+        const auto bit_or = [](Vector a, Vector b) { return _mm_or_si128(a, b); };
+        const auto bit_and_not = [](Vector a, Vector b) { return _mm_andnot_si128(a, b); };
+        const auto bit_and = [](Vector a, Vector b) { return _mm_and_si128(a, b); };
+        const auto zero = [] { return _mm_setzero_si128(); };
+        const auto mask = [](Vector a) { return static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(a))); };
+#endif
+        // Управляющие символы — байты из [0, 32) при сравнении со знаком
+        const Vector below_zero = splat(-1);
+        const Vector space = splat(' ');
+        for (size_t offset = 0; offset < CHUNK_SIZE; offset += VECTOR_SIZE) {
+            const Vector bytes = load(data + offset);
+            Vector is_separator = zero();
+            for (size_t i = 0; i < vector_separator_count_; ++i) {
+                is_separator = bit_or(is_separator, equal(bytes, splat(vector_separators_[i])));
+            }
+            const Vector is_control = bit_and(greater(bytes, below_zero), greater(space, bytes));
+            separators |= mask(is_separator) << offset;
+            control_chars |= mask(bit_and_not(is_separator, is_control)) << offset;
+        }
+        return;
+    }
+#endif
+    for (size_t i = 0; i < size; ++i) {
+        if (is_separator_[static_cast<unsigned char>(data[i])]) {
+            separators |= uint64_t{ 1 } << i;
+        }
+        else if (IsControlChar(data[i])) {
+            control_chars |= uint64_t{ 1 } << i;
+        }
+    }
+}
+
+TokenRange::Iterator::Iterator(const Tokenizer* tokenizer, std::string_view text)
+    : tokenizer_(tokenizer)
+    , text_(text)
+    , is_end_(false) {
+    Advance();
+}
+
+void TokenRange::Iterator::Advance() {
+    // next_begin_ за концом текста — последний разделитель стоял в самом конце
+    while (next_begin_ <= text_.size()) {
+        const size_t word_begin = next_begin_;
+        bool has_control_chars = false;
+        const size_t word_end = FindWordEnd(word_begin, has_control_chars);
+        next_begin_ = word_end + 1;
+        if (word_end > word_begin || !tokenizer_->IsSkippingEmptyWords()) {
+            token_ = { text_.substr(word_begin, word_end - word_begin), has_control_chars };
+            return;
+        }
+    }
+    is_end_ = true;
+}
+
+size_t TokenRange::Iterator::FindWordEnd(size_t begin, bool& has_control_chars) {
+    while (begin < text_.size()) {
+        if (begin < chunk_begin_ || begin >= chunk_begin_ + chunk_size_) {
+            // Хвост длинного текста разбирается целым блоком, заходящим назад
+            chunk_begin_ = text_.size() - begin >= Tokenizer::CHUNK_SIZE || text_.size() < Tokenizer::CHUNK_SIZE
+                ? begin
+                : text_.size() - Tokenizer::CHUNK_SIZE;
+            chunk_size_ = std::min(Tokenizer::CHUNK_SIZE, text_.size() - chunk_begin_);
+            tokenizer_->ClassifyChunk(text_.data() + chunk_begin_, chunk_size_, chunk_separators_, chunk_control_chars_);
+        }
+        const uint64_t rest = BitsFrom(begin - chunk_begin_);
+        const uint64_t separators = chunk_separators_ & rest;
+        if (separators != 0) {
+            const size_t end_offset = CountTrailingZeros(separators);
+            has_control_chars |= (chunk_control_chars_ & rest & ~BitsFrom(end_offset)) != 0;
+            return chunk_begin_ + end_offset;
+        }
+        has_control_chars |= (chunk_control_chars_ & rest) != 0;
+        begin = chunk_begin_ + chunk_size_;
+    }
+    return text_.size();
+}
+
+std::vector<std::string_view> SplitIntoWords(std::string_view text) {
+    static const Tokenizer tokenizer;
+    std::vector<std::string_view> result;
+    for (const Token& token : tokenizer.Tokenize(text)) {
+        result.push_back(token.word);
     }
     return result;
 }
@@ -0,0 +1,64 @@
+#include "term_dictionary.h"
+
+#include <algorithm>
+
+TermDictionary::TermDictionary(const TermDictionary& other)
+    : mapped_bytes_(other.mapped_bytes_)
+    , mapped_offsets_(other.mapped_offsets_)
+    , mapped_sorted_ids_(other.mapped_sorted_ids_)
+    , mapped_count_(other.mapped_count_) {
+    terms_.reserve(other.terms_.size());
+    term_ids_.reserve(other.term_ids_.size());
+    for (const std::string_view term : other.terms_) {
+        const std::string_view stored = storage_.Store(term);
+        term_ids_.emplace(stored, static_cast<TermId>(mapped_count_ + terms_.size()));
+        terms_.push_back(stored);
+    }
+}
+
+TermDictionary& TermDictionary::operator=(const TermDictionary& other) {
+    if (this != &other) {
+        *this = TermDictionary(other);
+    }
+    return *this;
+}
+
+TermId TermDictionary::Intern(std::string_view word) {
+    if (const auto it = term_ids_.find(word); it != term_ids_.end()) {
+        return it->second;
+    }
+    if (const TermId term_id = FindMapped(word); term_id != NO_TERM) {
+        return term_id;
+    }
+    const std::string_view stored = storage_.Store(word);
+    const TermId term_id = static_cast<TermId>(size());
+    terms_.push_back(stored);
+    term_ids_.emplace(stored, term_id);
+    return term_id;
+}
+
+TermId TermDictionary::Find(std::string_view word) const {
+    const auto it = term_ids_.find(word);
+    return it == term_ids_.end() ? FindMapped(word) : it->second;
+}
+
+size_t TermDictionary::GetMemoryUsage() const {
+    return storage_.GetMemoryUsage()
+        + terms_.capacity() * sizeof(std::string_view)
+        + term_ids_.bucket_count() * sizeof(void*)
+        + term_ids_.size() * (sizeof(std::pair<const std::string_view, TermId>) + sizeof(void*));
+}
+
+void TermDictionary::Map(const char* bytes, const uint64_t* offsets, const TermId* sorted_ids, TermId term_count) {
+    mapped_bytes_ = bytes;
+    mapped_offsets_ = offsets;
+    mapped_sorted_ids_ = sorted_ids;
+    mapped_count_ = term_count;
+}
+
+TermId TermDictionary::FindMapped(std::string_view word) const {
+    const TermId* end = mapped_sorted_ids_ + mapped_count_;
+    const TermId* it = std::lower_bound(mapped_sorted_ids_, end, word,
+        [this](TermId term_id, std::string_view value) { return GetTerm(term_id) < value; });
+    return it != end && GetTerm(*it) == word ? *it : NO_TERM;
+}
@@ -0,0 +1,188 @@
+#include "thread_pool.h"
+
+#include <optional>
+#include <stdexcept>
+#include <system_error>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+// Пул, которому принадлежит текущий поток, и номер потока в нём
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_worker = 0;
+
+std::mutex default_pool_mutex;
+std::optional<ThreadPoolOptions> default_pool_options;
+bool default_pool_created = false;
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t thread_count)
+    : ThreadPool(ThreadPoolOptions{ thread_count, {} }) {
+}
+
+ThreadPool::ThreadPool(const ThreadPoolOptions& options) {
+    for (const int cpu_id : options.cpu_ids) {
+        if (cpu_id < 0) {
+            throw std::invalid_argument("Invalid cpu id");
+        }
+    }
+    queues_.reserve(options.thread_count);
+    for (size_t i = 0; i < options.thread_count; ++i) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+    workers_.reserve(options.thread_count);
+    try {
+        for (size_t i = 0; i < options.thread_count; ++i) {
+            workers_.emplace_back([this, i] { WorkerLoop(i); });
+            if (!options.cpu_ids.empty()) {
+                PinWorker(i, options.cpu_ids[i % options.cpu_ids.size()]);
+            }
+        }
+    }
+    catch (...) {
+        Stop();
+        throw;
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    Stop();
+}
+
+ThreadPool& ThreadPool::GetDefault() {
+    static ThreadPool pool([] {
+        std::lock_guard lock(default_pool_mutex);
+        default_pool_created = true;
+        return default_pool_options.value_or(ThreadPoolOptions{});
+    }());
+    return pool;
+}
+
+void ThreadPool::ConfigureDefault(const ThreadPoolOptions& options) {
+    std::lock_guard lock(default_pool_mutex);
+    if (default_pool_created) {
+        throw std::logic_error("Default thread pool is already running");
+    }
+    default_pool_options = options;
+}
+
+bool ThreadPool::IsOwnWorkerThread() const {
+    return current_pool == this;
+}
+
+size_t ThreadPool::CountHelpers(size_t count) const {
+    size_t helper_count = std::min(count - 1, workers_.size());
+    if (IsOwnWorkerThread()) {
+        helper_count = std::min(helper_count, idle_workers_.load(std::memory_order_relaxed));
+    }
+    return helper_count;
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+    // Поток пула кладёт задачу себе, внешний — по кругу в очереди потоков
+    const size_t queue_index = IsOwnWorkerThread()
+        ? current_worker
+        : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    {
+        std::lock_guard lock(queues_[queue_index]->mutex);
+        queues_[queue_index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard lock(sleep_mutex_);
+        ++pending_tasks_;
+    }
+    has_tasks_.notify_one();
+}
+
+bool ThreadPool::TryTakeTask(size_t worker_index, std::function<void()>& task) {
+    {
+        WorkerQueue& own = *queues_[worker_index];
+        std::lock_guard lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for (size_t offset = 1; offset < queues_.size(); ++offset) {
+        WorkerQueue& victim = *queues_[(worker_index + offset) % queues_.size()];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::WorkerLoop(size_t worker_index) {
+    current_pool = this;
+    current_worker = worker_index;
+    while (true) {
+        std::function<void()> task;
+        if (TryTakeTask(worker_index, task)) {
+            --pending_tasks_;
+            task();
+            continue;
+        }
+        std::unique_lock lock(sleep_mutex_);
+        ++idle_workers_;
+        has_tasks_.wait(lock, [this] { return stopping_ || pending_tasks_ > 0; });
+        --idle_workers_;
+        if (stopping_ && pending_tasks_ == 0) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::PinWorker(size_t worker_index, int cpu_id) {
+#ifdef __linux__
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    if (cpu_id >= CPU_SETSIZE) {
+        throw std::invalid_argument("Invalid cpu id");
+    }
+    CPU_SET(cpu_id, &cpu_set);
+    const int error = pthread_setaffinity_np(workers_[worker_index].native_handle(), sizeof(cpu_set), &cpu_set);
+    if (error != 0) {
+        throw std::system_error(error, std::generic_category(), "pthread_setaffinity_np");
+    }
+#endif
+}
+
+void ThreadPool::Stop() {
+    {
+        std::lock_guard lock(sleep_mutex_);
+        stopping_ = true;
+    }
+    has_tasks_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+}
+
+void ThreadPool::ParallelForState::Run() {
+    for (size_t i = next_index++; i < count; i = next_index++) {
+        std::exception_ptr error;
+        try {
+            body(i);
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        std::lock_guard lock(mutex);
+        if (error && !exception) {
+            exception = error;
+        }
+        if (++completed == count) {
+            done.notify_all();
+        }
+    }
+}
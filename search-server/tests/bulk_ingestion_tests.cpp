@@ -0,0 +1,118 @@
+#include "search_server.h"
+#include "test_framework.h"
+#include "test_utils.h"
+#include "tests.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+struct Corpus {
+    vector<string> words;
+    vector<string> texts;
+    vector<NewDocument> documents;
+};
+
+// Слова повторяются и внутри документа, и между документами; id идут вразнобой
+Corpus MakeCorpus(int document_count) {
+    mt19937 generator(12);
+    Corpus corpus;
+    for (int i = 0; i < 300; ++i) {
+        corpus.words.push_back("w"s + to_string(i));
+    }
+    corpus.words.push_back("the"s);
+    uniform_int_distribution<size_t> word(0, corpus.words.size() - 1);
+    uniform_int_distribution<int> length(1, 12);
+    uniform_int_distribution<int> rating(-10, 10);
+    for (int i = 0; i < document_count; ++i) {
+        string text = corpus.words[word(generator)];
+        for (int j = length(generator); j > 1; --j) {
+            text += ' ';
+            text += corpus.words[word(generator)];
+        }
+        corpus.texts.push_back(move(text));
+    }
+    for (int i = 0; i < document_count; ++i) {
+        const int id = (i * 7919) % document_count;
+        corpus.documents.push_back({ id, corpus.texts[i], static_cast<DocumentStatus>(i % 3), { rating(generator), rating(generator) } });
+    }
+    return corpus;
+}
+
+void AssertSameIndex(const SearchServer& expected, const SearchServer& actual, const Corpus& corpus) {
+    ASSERT_EQUAL(expected.GetDocumentCount(), actual.GetDocumentCount());
+    // Файл индекса содержит словарь в порядке TermId, списки документов блоками,
+    // рейтинги, статусы и термины документов
+    ASSERT(SaveIndexBytes(expected, "search_server_expected.idx"s) == SaveIndexBytes(actual, "search_server_actual.idx"s));
+    for (const string& word : corpus.words) {
+        const auto expected_stats = expected.GetTermStatistics(word);
+        const auto actual_stats = actual.GetTermStatistics(word);
+        ASSERT_EQUAL_HINT(expected_stats.has_value(), actual_stats.has_value(), word);
+        if (expected_stats) {
+            ASSERT_EQUAL_HINT(expected_stats->document_count, actual_stats->document_count, word);
+            ASSERT_EQUAL_HINT(expected_stats->inverse_document_freq, actual_stats->inverse_document_freq, word);
+            ASSERT_EQUAL_HINT(expected_stats->max_term_freq, actual_stats->max_term_freq, word);
+        }
+    }
+    for (const int document_id : expected) {
+        ASSERT(expected.GetWordFrequencies(document_id) == actual.GetWordFrequencies(document_id));
+    }
+    for (size_t i = 0; i + 2 < corpus.words.size(); i += 25) {
+        const string query = corpus.words[i] + " "s + corpus.words[i + 1] + " -"s + corpus.words[i + 2];
+        for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT }) {
+            AssertSameDocuments(expected.FindTopDocuments(query, status, 20), actual.FindTopDocuments(query, status, 20), query);
+        }
+    }
+}
+
+void TestAddDocumentsMatchesAddDocument() {
+    const Corpus corpus = MakeCorpus(3000);
+    SearchServer one_by_one("the"s);
+    for (const NewDocument& document : corpus.documents) {
+        one_by_one.AddDocument(document.id, document.text, document.status, document.ratings);
+    }
+    SearchServer bulk("the"s);
+    bulk.AddDocuments(corpus.documents);
+    AssertSameIndex(one_by_one, bulk, corpus);
+
+    // Пачка поверх уже заполненного индекса: новые слова и старые вперемешку
+    const Corpus more = MakeCorpus(3200);
+    vector<NewDocument> extra(more.documents.begin(), more.documents.end());
+    extra.erase(remove_if(extra.begin(), extra.end(), [](const NewDocument& document) { return document.id < 3000; }), extra.end());
+    for (const NewDocument& document : extra) {
+        one_by_one.AddDocument(document.id, document.text, document.status, document.ratings);
+    }
+    bulk.AddDocuments(extra);
+    AssertSameIndex(one_by_one, bulk, corpus);
+}
+
+void TestAddDocumentsLeavesIndexOnError() {
+    SearchServer server("the"s);
+    server.AddDocument(1, "w1 w2"s, DocumentStatus::ACTUAL, { 1 });
+    const vector<char> before = SaveIndexBytes(server, "search_server_before.idx"s);
+    const vector<NewDocument> documents = {
+        { 2, "w3 w4"s, DocumentStatus::ACTUAL, { 1 } },
+        { 3, "w5 w\x12"s, DocumentStatus::ACTUAL, { 1 } },
+    };
+    bool thrown = false;
+    try {
+        server.AddDocuments(documents);
+    }
+    catch (const invalid_argument&) {
+        thrown = true;
+    }
+    ASSERT(thrown);
+    ASSERT(before == SaveIndexBytes(server, "search_server_after.idx"s));
+}
+
+} // namespace
+
+void TestBulkIngestion() {
+    RUN_TEST(TestAddDocumentsMatchesAddDocument);
+    RUN_TEST(TestAddDocumentsLeavesIndexOnError);
+}
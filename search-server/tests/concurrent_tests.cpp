@@ -0,0 +1,63 @@
+#include "concurrent_search_server.h"
+#include "search_server.h"
+#include "test_framework.h"
+#include "test_utils.h"
+#include "tests.h"
+
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+bool ThrowsRuntimeError(ConcurrentSearchServer& server, int fail_on_call) {
+    int call = 0;
+    try {
+        server.Write([&call, fail_on_call](SearchServer& copy) {
+            copy.AddDocument(3, "black cat"s, DocumentStatus::ACTUAL, { 2 });
+            if (++call == fail_on_call) {
+                throw runtime_error("write failed"s);
+            }
+        });
+    }
+    catch (const runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+// Копия, на которой Write бросил исключение, восстанавливается по другой:
+// после следующего переключения читатели видят тот же индекс
+void TestConcurrentWriteFailureKeepsCopiesInSync() {
+    SearchServer expected("and in of the"s);
+    ConcurrentSearchServer server("and in of the"s);
+    for (int id = 0; id < 3; ++id) {
+        expected.AddDocument(id, "white cat number "s + to_string(id), DocumentStatus::ACTUAL, { id });
+        server.AddDocument(id, "white cat number "s + to_string(id), DocumentStatus::ACTUAL, { id });
+    }
+
+    // Каждая запись переключает читателей на другую копию, так что обе проверки
+    // ниже смотрят в разные копии
+    // Сбой на первой копии: изменение не видно ни в одной
+    ASSERT(ThrowsRuntimeError(server, 1));
+    for (int i = 0; i < 2; ++i) {
+        AssertSameDocuments(expected.FindTopDocuments("cat"s), server.FindTopDocuments("cat"s), "cat"s);
+        server.SetRankingMode(RankingMode::EXHAUSTIVE);
+    }
+
+    // Сбой на второй копии: изменение опубликовано и остаётся в обеих
+    ASSERT(ThrowsRuntimeError(server, 2));
+    expected.AddDocument(3, "black cat"s, DocumentStatus::ACTUAL, { 2 });
+    for (int i = 0; i < 2; ++i) {
+        AssertSameDocuments(expected.FindTopDocuments("cat"s), server.FindTopDocuments("cat"s), "cat"s);
+        ASSERT_EQUAL(server.GetDocumentCount(), expected.GetDocumentCount());
+        server.SetRankingMode(RankingMode::EXHAUSTIVE);
+    }
+}
+
+} // namespace
+
+void TestConcurrentSearchServer() {
+    RUN_TEST(TestConcurrentWriteFailureKeepsCopiesInSync);
+}
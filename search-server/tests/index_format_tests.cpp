@@ -0,0 +1,244 @@
+#include "index_format.h"
+#include "search_server.h"
+#include "test_framework.h"
+#include "test_utils.h"
+#include "tests.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const vector<string> QUERIES = {
+    "cat"s, "fluffy tail"s, "white dog -collar"s, "groomed starling"s, "+dog tail"s, "missing"s,
+};
+
+SearchServer MakeServer() {
+    SearchServer server("and in of the"s);
+    server.AddDocument(1, "white cat fashionable collar"s, DocumentStatus::ACTUAL, { 8, -3 });
+    server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    server.AddDocument(3, "groomed dog expressive eyes"s, DocumentStatus::ACTUAL, { 5, -12, 2, 1 });
+    server.AddDocument(4, "groomed starling eugene"s, DocumentStatus::BANNED, { 9 });
+    server.AddDocument(5, "white dog long tail"s, DocumentStatus::ACTUAL, { 1, 2 });
+    server.AddDocument(6, "tail of the dog"s, DocumentStatus::IRRELEVANT, { 3 });
+    server.AddDocument(7, "cat and dog"s, DocumentStatus::ACTUAL, { 4 });
+    server.RemoveDocument(5);
+    return server;
+}
+
+bool ThrowsRuntimeError(const string& path, bool verify) {
+    try {
+        SearchServer::OpenIndex(path, verify);
+    }
+    catch (const runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+const IndexFileHeader& GetHeader(const vector<char>& bytes) {
+    return *reinterpret_cast<const IndexFileHeader*>(bytes.data());
+}
+
+// Записывает файл с пересчитанной контрольной суммой, как будто повреждение внёс SaveIndex
+void WriteWithChecksum(const string& path, vector<char> bytes) {
+    auto& header = *reinterpret_cast<IndexFileHeader*>(bytes.data());
+    header.checksum = ComputeIndexChecksum(reinterpret_cast<const uint8_t*>(bytes.data()) + sizeof(IndexFileHeader),
+        bytes.size() - sizeof(IndexFileHeader));
+    WriteBytes(path, bytes);
+}
+
+void TestIndexFileRoundTrip() {
+    const SearchServer original = MakeServer();
+    TemporaryFile file("search_server_round_trip.idx"s);
+    original.SaveIndex(file.GetPath());
+    ASSERT(!ThrowsRuntimeError(file.GetPath(), true));
+    const SearchServer opened = SearchServer::OpenIndex(file.GetPath());
+
+    ASSERT_EQUAL(opened.GetDocumentCount(), original.GetDocumentCount());
+    ASSERT(vector<int>(opened.begin(), opened.end()) == vector<int>(original.begin(), original.end()));
+    for (const string& query : QUERIES) {
+        for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED, DocumentStatus::IRRELEVANT }) {
+            AssertSameDocuments(original.FindTopDocuments(query, status), opened.FindTopDocuments(query, status), query);
+        }
+    }
+    for (const int document_id : original) {
+        ASSERT(original.GetWordFrequencies(document_id) == opened.GetWordFrequencies(document_id));
+        for (const string& query : QUERIES) {
+            ASSERT(original.MatchDocument(query, document_id) == opened.MatchDocument(query, document_id));
+        }
+    }
+
+    // Отображённый индекс можно изменять дальше
+    SearchServer changed = SearchServer::OpenIndex(file.GetPath());
+    SearchServer expected = MakeServer();
+    changed.AddDocument(8, "fluffy white cat"s, DocumentStatus::ACTUAL, { 2 });
+    expected.AddDocument(8, "fluffy white cat"s, DocumentStatus::ACTUAL, { 2 });
+    changed.RemoveDocument(2);
+    expected.RemoveDocument(2);
+    changed.RemoveDocument(3);
+    expected.RemoveDocument(3);
+    // id удалённого документа файла можно занять заново
+    changed.AddDocument(3, "groomed white starling"s, DocumentStatus::ACTUAL, { 6 });
+    expected.AddDocument(3, "groomed white starling"s, DocumentStatus::ACTUAL, { 6 });
+    ASSERT_EQUAL(changed.GetDocumentCount(), expected.GetDocumentCount());
+    ASSERT(vector<int>(changed.begin(), changed.end()) == vector<int>(expected.begin(), expected.end()));
+    for (const string& query : QUERIES) {
+        AssertSameDocuments(expected.FindTopDocuments(query), changed.FindTopDocuments(query), query);
+    }
+}
+
+// Перезапись файла не трогает индекс, который уже читает прежний файл
+void TestIndexFileReplacedWhileOpen() {
+    TemporaryFile file("search_server_replaced.idx"s);
+    const SearchServer original = MakeServer();
+    original.SaveIndex(file.GetPath());
+    const SearchServer opened = SearchServer::OpenIndex(file.GetPath());
+
+    SearchServer replacement("and in of the"s);
+    replacement.AddDocument(10, "black starling"s, DocumentStatus::ACTUAL, { 1 });
+    replacement.SaveIndex(file.GetPath());
+
+    for (const string& query : QUERIES) {
+        AssertSameDocuments(original.FindTopDocuments(query), opened.FindTopDocuments(query), query);
+    }
+    for (const int document_id : original) {
+        ASSERT(original.GetWordFrequencies(document_id) == opened.GetWordFrequencies(document_id));
+    }
+    const SearchServer reopened = SearchServer::OpenIndex(file.GetPath());
+    ASSERT_EQUAL(reopened.GetDocumentCount(), 1);
+    AssertSameDocuments(replacement.FindTopDocuments("starling"s), reopened.FindTopDocuments("starling"s), "starling"s);
+
+    // Временные файлы не остаются
+    const filesystem::path directory = filesystem::path(file.GetPath()).parent_path();
+    for (const auto& entry : filesystem::directory_iterator(directory)) {
+        ASSERT_HINT(entry.path().filename().string().rfind("search_server_replaced.idx.tmp"s, 0) != 0, entry.path().string());
+    }
+}
+
+void TestIndexFileRejectsCorruption() {
+    TemporaryFile file("search_server_corrupted.idx"s);
+    MakeServer().SaveIndex(file.GetPath());
+    const vector<char> bytes = ReadBytes(file.GetPath());
+
+    vector<char> truncated(bytes.begin(), bytes.end() - 16);
+    WriteBytes(file.GetPath(), truncated);
+    ASSERT_HINT(ThrowsRuntimeError(file.GetPath(), true), "truncated file"s);
+    ASSERT_HINT(ThrowsRuntimeError(file.GetPath(), false), "truncated file"s);
+
+    truncated.assign(bytes.begin(), bytes.begin() + sizeof(IndexFileHeader) / 2);
+    WriteBytes(file.GetPath(), truncated);
+    ASSERT_HINT(ThrowsRuntimeError(file.GetPath(), false), "truncated header"s);
+
+    vector<char> flipped = bytes;
+    flipped[GetHeader(bytes).sections[POSTING_DATA].offset] ^= 0x01;
+    WriteBytes(file.GetPath(), flipped);
+    ASSERT_HINT(ThrowsRuntimeError(file.GetPath(), true), "checksum"s);
+
+    vector<char> bad_magic = bytes;
+    bad_magic[0] = 'X';
+    WriteBytes(file.GetPath(), bad_magic);
+    ASSERT_HINT(ThrowsRuntimeError(file.GetPath(), false), "magic"s);
+}
+
+// С verify повреждённое содержимое отвергается, даже если контрольная сумма сходится
+void TestIndexFileVerifiesContents() {
+    TemporaryFile file("search_server_ranges.idx"s);
+    MakeServer().SaveIndex(file.GetPath());
+    const vector<char> bytes = ReadBytes(file.GetPath());
+    const IndexFileHeader& header = GetHeader(bytes);
+
+    vector<char> bad_term = bytes;
+    DocumentTerm term;
+    memcpy(&term, bytes.data() + header.sections[DOCUMENT_TERMS].offset, sizeof(term));
+    term.term_id = 1000000;
+    memcpy(bad_term.data() + header.sections[DOCUMENT_TERMS].offset, &term, sizeof(term));
+    WriteWithChecksum(file.GetPath(), bad_term);
+    ASSERT_HINT(ThrowsRuntimeError(file.GetPath(), true), "document term id"s);
+
+    vector<char> bad_block = bytes;
+    PostingList::BlockInfo block;
+    memcpy(&block, bytes.data() + header.sections[POSTING_BLOCKS].offset, sizeof(block));
+    block.last_ordinal = 1000000;
+    memcpy(bad_block.data() + header.sections[POSTING_BLOCKS].offset, &block, sizeof(block));
+    WriteWithChecksum(file.GetPath(), bad_block);
+    ASSERT_HINT(ThrowsRuntimeError(file.GetPath(), true), "block ordinal"s);
+
+    // Разность номеров внутри блока уводит за последний документ. Списки малы:
+    // первая запись блока — два байта, следом разность второй записи
+    const auto* lists = reinterpret_cast<const IndexPostingListRecord*>(bytes.data() + header.sections[POSTING_LISTS].offset);
+    const auto* blocks = reinterpret_cast<const PostingList::BlockInfo*>(bytes.data() + header.sections[POSTING_BLOCKS].offset);
+    const size_t list_count = header.sections[POSTING_LISTS].size / sizeof(IndexPostingListRecord);
+    size_t data_offset = 0;
+    for (size_t list = 0; list < list_count && data_offset == 0; ++list) {
+        for (size_t i = lists[list].first_block; i < lists[list].first_block + lists[list].block_count; ++i) {
+            if (blocks[i].count >= 2) {
+                data_offset = header.sections[POSTING_DATA].offset + lists[list].data_offset + blocks[i].offset;
+                break;
+            }
+        }
+    }
+    ASSERT(data_offset != 0);
+    vector<char> bad_delta = bytes;
+    bad_delta[data_offset + 2] = 0x7F;
+    WriteWithChecksum(file.GetPath(), bad_delta);
+    ASSERT_HINT(ThrowsRuntimeError(file.GetPath(), true), "posting ordinal"s);
+
+    const size_t ids_offset = header.sections[DOCUMENT_IDS].offset;
+    vector<char> unsorted_ids = bytes;
+    swap_ranges(unsorted_ids.begin() + ids_offset, unsorted_ids.begin() + ids_offset + sizeof(IndexDocumentId),
+        unsorted_ids.begin() + ids_offset + sizeof(IndexDocumentId));
+    WriteWithChecksum(file.GetPath(), unsorted_ids);
+    ASSERT_HINT(ThrowsRuntimeError(file.GetPath(), true), "document id order"s);
+
+    vector<char> missing_id = bytes;
+    IndexFileHeader& missing_header = *reinterpret_cast<IndexFileHeader*>(missing_id.data());
+    missing_header.sections[DOCUMENT_IDS].size -= sizeof(IndexDocumentId);
+    WriteWithChecksum(file.GetPath(), missing_id);
+    ASSERT_HINT(ThrowsRuntimeError(file.GetPath(), true), "missing document id"s);
+
+    WriteBytes(file.GetPath(), bytes);
+    ASSERT(!ThrowsRuntimeError(file.GetPath(), true));
+}
+
+// Без verify записи, по которым индекс находит данные, всё равно проверяются:
+// при открытии — границы списков, при поиске документа — номер из секции id
+void TestIndexFileChecksRecordsWithoutVerify() {
+    TemporaryFile file("search_server_records.idx"s);
+    const SearchServer original = MakeServer();
+    original.SaveIndex(file.GetPath());
+    const vector<char> bytes = ReadBytes(file.GetPath());
+    const IndexFileHeader& header = GetHeader(bytes);
+
+    vector<char> bad_list = bytes;
+    auto* lists = reinterpret_cast<IndexPostingListRecord*>(bad_list.data() + header.sections[POSTING_LISTS].offset);
+    lists[0].data_size = header.sections[POSTING_DATA].size + 1;
+    WriteBytes(file.GetPath(), bad_list);
+    ASSERT_HINT(ThrowsRuntimeError(file.GetPath(), false), "posting list bounds"s);
+
+    vector<char> bad_ordinal = bytes;
+    auto* ids = reinterpret_cast<IndexDocumentId*>(bad_ordinal.data() + header.sections[DOCUMENT_IDS].offset);
+    const int lost_id = ids[0].id;
+    ids[0].ordinal = 1000000;
+    WriteBytes(file.GetPath(), bad_ordinal);
+    const SearchServer opened = SearchServer::OpenIndex(file.GetPath());
+    ASSERT_EQUAL(opened.GetDocumentCount(), original.GetDocumentCount());
+    ASSERT(opened.GetWordFrequencies(lost_id).empty());
+    ASSERT(find(opened.begin(), opened.end(), lost_id) == opened.end());
+}
+
+} // namespace
+
+void TestIndexFile() {
+    RUN_TEST(TestIndexFileRoundTrip);
+    RUN_TEST(TestIndexFileReplacedWhileOpen);
+    RUN_TEST(TestIndexFileRejectsCorruption);
+    RUN_TEST(TestIndexFileVerifiesContents);
+    RUN_TEST(TestIndexFileChecksRecordsWithoutVerify);
+}
@@ -0,0 +1,19 @@
+#include "tests.h"
+
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    TestRanking();
+    TestSegmentedSearchServer();
+    TestRequestStats();
+    TestIndexFile();
+    TestBulkIngestion();
+    TestQuerySyntax();
+    TestRemoval();
+    TestConcurrentSearchServer();
+    TestShardedSearchServer();
+    TestPagination();
+    cerr << "All tests passed"s << endl;
+}
@@ -0,0 +1,148 @@
+#include "paginator.h"
+#include "search_cursor.h"
+#include "search_server.h"
+#include "test_framework.h"
+#include "test_utils.h"
+#include "tests.h"
+
+#include <algorithm>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const vector<string> QUERIES = { "cat"s, "fluffy cat"s, "white dog -collar"s, "cat dog tail"s };
+
+// Одинаковые тексты с одинаковым рейтингом дают серии равных документов,
+// которые при маленьких страницах пересекают границу страниц
+SearchServer MakeServer() {
+    SearchServer server("and in of the"s);
+    int id = 0;
+    for (int i = 0; i < 7; ++i) {
+        server.AddDocument(id++, "fluffy cat"s, DocumentStatus::ACTUAL, { 5 });
+    }
+    for (int i = 0; i < 4; ++i) {
+        server.AddDocument(id++, "fluffy cat"s, DocumentStatus::ACTUAL, { i });
+    }
+    for (int i = 0; i < 5; ++i) {
+        server.AddDocument(id++, "white dog long tail"s, DocumentStatus::ACTUAL, { 2 });
+    }
+    server.AddDocument(id++, "white cat fashionable collar"s, DocumentStatus::ACTUAL, { 8 });
+    server.AddDocument(id++, "cat and dog"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(id++, "groomed dog expressive eyes"s, DocumentStatus::BANNED, { 3 });
+    return server;
+}
+
+// Вся выдача в порядке IsMoreRelevantStrict
+vector<Document> FindAll(const SearchServer& server, const string& query) {
+    vector<Document> documents = server.FindTopDocuments(query, DocumentStatus::ACTUAL, 1000);
+    sort(documents.begin(), documents.end(), IsMoreRelevantStrict);
+    return documents;
+}
+
+vector<Document> FindAllByPages(const SearchServer& server, const PreparedQuery& query, size_t page_size) {
+    vector<Document> documents;
+    SearchCursor cursor;
+    while (true) {
+        const SearchPage page = server.FindPage(query, cursor, page_size);
+        ASSERT(page.documents.size() <= page_size);
+        documents.insert(documents.end(), page.documents.begin(), page.documents.end());
+        if (page.is_last) {
+            return documents;
+        }
+        ASSERT_EQUAL(page.documents.size(), page_size);
+        cursor = page.next;
+    }
+}
+
+bool ThrowsInvalidArgument(const SearchServer& server, const PreparedQuery& query, const SearchCursor& cursor) {
+    try {
+        server.FindPage(query, cursor, 3);
+    }
+    catch (const invalid_argument&) {
+        return true;
+    }
+    return false;
+}
+
+// Страницы подряд дают всю выдачу без повторов и пропусков, в том числе когда
+// серия равных документов переходит через границу страниц
+void TestPagesConcatenateToFullResult() {
+    const SearchServer server = MakeServer();
+    for (const string& text : QUERIES) {
+        const PreparedQuery query = server.PrepareQuery(text);
+        const vector<Document> expected = FindAll(server, text);
+        for (size_t page_size = 1; page_size <= expected.size() + 1; ++page_size) {
+            const vector<Document> by_pages = FindAllByPages(server, query, page_size);
+            AssertSameDocuments(expected, by_pages, text);
+
+            vector<Document> by_paginator;
+            for (const auto page : PaginateSearch(server, query, page_size)) {
+                by_paginator.insert(by_paginator.end(), page.begin(), page.end());
+            }
+            AssertSameDocuments(expected, by_paginator, text);
+
+            set<int> ids;
+            for (const Document& document : by_pages) {
+                ids.insert(document.id);
+            }
+            ASSERT_EQUAL_HINT(ids.size(), by_pages.size(), text);
+        }
+    }
+}
+
+// Курсор, переданный клиенту строкой, продолжает выдачу с того же места
+void TestCursorStringRoundTrip() {
+    const SearchServer server = MakeServer();
+    const PreparedQuery query = server.PrepareQuery("fluffy cat"s);
+    ASSERT(SearchCursor::FromString(SearchCursor().ToString()).IsStart());
+
+    const SearchPage first = server.FindPage(query, SearchCursor(), 4);
+    ASSERT(!first.is_last);
+    const SearchCursor restored = SearchCursor::FromString(first.next.ToString());
+    ASSERT(!restored.IsStart());
+    ASSERT_EQUAL(restored.GetGeneration(), first.next.GetGeneration());
+    ASSERT_EQUAL(restored.ToString(), first.next.ToString());
+    AssertSameDocuments(server.FindPage(query, first.next, 4).documents, server.FindPage(query, restored, 4).documents, "fluffy cat"s);
+
+    for (const string& text : { "xyz"s, "0"s, first.next.ToString() + "0"s, first.next.ToString().substr(1) }) {
+        bool is_rejected = false;
+        try {
+            SearchCursor::FromString(text);
+        }
+        catch (const invalid_argument&) {
+            is_rejected = true;
+        }
+        ASSERT_HINT(is_rejected, text);
+    }
+}
+
+// Курсор прошлого поколения индекса отвергается, в том числе восстановленный из строки
+void TestStaleCursorIsRejected() {
+    SearchServer server = MakeServer();
+    const PreparedQuery query = server.PrepareQuery("cat"s);
+    const SearchCursor cursor = server.FindPage(query, SearchCursor(), 3).next;
+    const string text = cursor.ToString();
+    ASSERT(!ThrowsInvalidArgument(server, query, cursor));
+
+    server.AddDocument(100, "black cat"s, DocumentStatus::ACTUAL, { 1 });
+    ASSERT(ThrowsInvalidArgument(server, query, cursor));
+    ASSERT(ThrowsInvalidArgument(server, query, SearchCursor::FromString(text)));
+    ASSERT(!ThrowsInvalidArgument(server, query, SearchCursor()));
+
+    const SearchCursor fresh = server.FindPage(query, SearchCursor(), 3).next;
+    server.RemoveDocument(100);
+    ASSERT(ThrowsInvalidArgument(server, query, fresh));
+}
+
+} // namespace
+
+void TestPagination() {
+    RUN_TEST(TestPagesConcatenateToFullResult);
+    RUN_TEST(TestCursorStringRoundTrip);
+    RUN_TEST(TestStaleCursorIsRejected);
+}
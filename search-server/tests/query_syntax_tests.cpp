@@ -0,0 +1,66 @@
+#include "search_server.h"
+#include "test_framework.h"
+#include "test_utils.h"
+#include "tests.h"
+
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+SearchServer MakeServer() {
+    SearchServer server("and"s);
+    server.AddDocument(1, "call +7 495 and ask"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(2, "ask for ++x operator"s, DocumentStatus::ACTUAL, { 2 });
+    server.AddDocument(3, "ask the operator"s, DocumentStatus::ACTUAL, { 3 });
+    server.AddDocument(4, "call the operator"s, DocumentStatus::ACTUAL, { 4 });
+    return server;
+}
+
+bool ThrowsInvalidArgument(const SearchServer& server, const string& query) {
+    try {
+        server.FindTopDocuments(query);
+    }
+    catch (const invalid_argument&) {
+        return true;
+    }
+    return false;
+}
+
+// По умолчанию '+' — часть слова, как до появления обязательных слов
+void TestPlainSyntaxKeepsPlusInWords() {
+    const SearchServer server = MakeServer();
+    ASSERT(server.GetQuerySyntax() == QuerySyntax::PLAIN);
+    ASSERT_EQUAL(DescribeIds(server.FindTopDocuments("+7"s)), "1 "s);
+    ASSERT_EQUAL(DescribeIds(server.FindTopDocuments("++x"s)), "2 "s);
+    ASSERT_EQUAL(DescribeIds(server.FindTopDocuments("-+7 ask"s)), "3 2 "s);
+    ASSERT(server.FindTopDocuments("+operator"s).empty());
+    ASSERT_EQUAL(get<0>(server.MatchDocument("+7 call"s, 1)).size(), 2u);
+}
+
+void TestRequiredTermSyntax() {
+    SearchServer server = MakeServer();
+    server.SetQuerySyntax(QuerySyntax::REQUIRED_TERMS);
+    ASSERT_EQUAL(DescribeIds(server.FindTopDocuments("ask +operator"s)), "3 2 4 "s);
+    ASSERT_EQUAL(DescribeIds(server.FindTopDocuments("+ask +operator"s)), "3 2 "s);
+    ASSERT_EQUAL(DescribeIds(server.FindTopDocuments("+call -+7"s)), "4 "s);
+    ASSERT(get<0>(server.MatchDocument("+call ask"s, 3)).empty());
+    ASSERT(ThrowsInvalidArgument(server, "++x"s));
+    ASSERT(ThrowsInvalidArgument(server, "+"s));
+    ASSERT(ThrowsInvalidArgument(server, "+-x"s));
+
+    // Подготовленный запрос сохраняет синтаксис, с которым его разобрали
+    const PreparedQuery prepared = server.PrepareQuery("+call"s);
+    server.SetQuerySyntax(QuerySyntax::PLAIN);
+    ASSERT_EQUAL(DescribeIds(server.FindTopDocuments(prepared)), "4 1 "s);
+    ASSERT(server.FindTopDocuments("+call"s).empty());
+}
+
+} // namespace
+
+void TestQuerySyntax() {
+    RUN_TEST(TestPlainSyntaxKeepsPlusInWords);
+    RUN_TEST(TestRequiredTermSyntax);
+}
@@ -0,0 +1,87 @@
+#include "search_server.h"
+#include "test_framework.h"
+#include "test_utils.h"
+#include "tests.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// Корпус с множеством равных по релевантности и рейтингу документов: слова из
+// пяти букв, рейтинги 0 и 1
+void AddTieHeavyDocuments(SearchServer& server, mt19937& generator, int document_count) {
+    uniform_int_distribution<int> letter(0, 4);
+    uniform_int_distribution<int> length(1, 4);
+    uniform_int_distribution<int> rating(0, 1);
+    for (int id = 0; id < document_count; ++id) {
+        string text;
+        for (int i = length(generator); i > 0; --i) {
+            text += static_cast<char>('a' + letter(generator));
+            text += ' ';
+        }
+        server.AddDocument(id, text, DocumentStatus::ACTUAL, { rating(generator) });
+    }
+}
+
+string MakeQuery(mt19937& generator) {
+    uniform_int_distribution<int> letter(0, 4);
+    uniform_int_distribution<int> length(1, 3);
+    string query(1, static_cast<char>('a' + letter(generator)));
+    for (int i = length(generator); i > 1; --i) {
+        query += ' ';
+        query += static_cast<char>('a' + letter(generator));
+    }
+    return query;
+}
+
+void AssertRankingModesAgree(SearchServer& server, const string& query) {
+    server.SetRankingMode(RankingMode::EXHAUSTIVE);
+    const auto exhaustive = server.FindTopDocuments(query);
+    const auto parallel = server.FindTopDocuments(execution::par, query);
+    server.SetRankingMode(RankingMode::MAX_SCORE);
+    const auto max_score = server.FindTopDocuments(query);
+    AssertSameDocuments(exhaustive, parallel, query);
+    AssertSameDocuments(exhaustive, max_score, query);
+}
+
+void TestRankingModesAgreeOnTies() {
+    mt19937 generator(2024);
+    for (int run = 0; run < 2000; ++run) {
+        SearchServer server(""s);
+        AddTieHeavyDocuments(server, generator, 30);
+        AssertRankingModesAgree(server, MakeQuery(generator));
+    }
+}
+
+// Достаточно записей, чтобы параллельный поиск делил документы на части
+void TestRankingModesAgreeOnTiesInParallelParts() {
+    mt19937 generator(7);
+    SearchServer server(""s);
+    AddTieHeavyDocuments(server, generator, 60000);
+    for (const string& query : { "a b"s, "e e c"s, "a b c d e"s }) {
+        AssertRankingModesAgree(server, query);
+    }
+}
+
+void TestEqualDocumentsRankedById() {
+    SearchServer server(""s);
+    server.AddDocument(5, "cat"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(2, "cat"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(9, "cat"s, DocumentStatus::ACTUAL, { 2 });
+    server.AddDocument(3, "cat"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(4, "dog"s, DocumentStatus::ACTUAL, { 1 });
+    const auto documents = server.FindTopDocuments("cat"s);
+    ASSERT_EQUAL(DescribeIds(documents), "9 2 3 5 "s);
+}
+
+} // namespace
+
+void TestRanking() {
+    RUN_TEST(TestRankingModesAgreeOnTies);
+    RUN_TEST(TestEqualDocumentsRankedById);
+    RUN_TEST(TestRankingModesAgreeOnTiesInParallelParts);
+}
@@ -0,0 +1,126 @@
+#include "index_format.h"
+#include "search_server.h"
+#include "test_framework.h"
+#include "test_utils.h"
+#include "tests.h"
+
+#include <execution>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const vector<string> QUERIES = { "w1"s, "w2 w3"s, "w4 -w5"s, "w0 w6 w7 w8"s, "w9 w10 w11"s };
+
+string MakeText(mt19937& generator) {
+    uniform_int_distribution<int> word(0, 40);
+    uniform_int_distribution<int> length(1, 8);
+    string text = "w"s + to_string(word(generator));
+    for (int i = length(generator); i > 1; --i) {
+        text += " w"s + to_string(word(generator));
+    }
+    return text;
+}
+
+// Число слотов таблицы документов: в файл индекса попадает запись на каждый
+size_t CountDocumentSlots(const SearchServer& server) {
+    const vector<char> bytes = SaveIndexBytes(server, "search_server_slots.idx"s);
+    const auto& header = *reinterpret_cast<const IndexFileHeader*>(bytes.data());
+    return header.sections[DOCUMENTS].size / sizeof(IndexDocumentRecord);
+}
+
+// Тот же набор живых документов, добавленных в новый сервер
+SearchServer Rebuild(const map<int, pair<string, int>>& live) {
+    SearchServer server(""s);
+    for (const auto& [id, document] : live) {
+        server.AddDocument(id, document.first, DocumentStatus::ACTUAL, { document.second });
+    }
+    return server;
+}
+
+void AssertSameResults(const SearchServer& expected, const SearchServer& actual) {
+    ASSERT_EQUAL(expected.GetDocumentCount(), actual.GetDocumentCount());
+    for (const string& query : QUERIES) {
+        AssertSameDocuments(expected.FindTopDocuments(query, DocumentStatus::ACTUAL, 50), actual.FindTopDocuments(query, DocumentStatus::ACTUAL, 50), query);
+    }
+    for (const int document_id : expected) {
+        ASSERT(expected.GetWordFrequencies(document_id) == actual.GetWordFrequencies(document_id));
+        for (const string& query : QUERIES) {
+            ASSERT(expected.MatchDocument(query, document_id) == actual.MatchDocument(query, document_id));
+        }
+    }
+}
+
+// При постоянных добавлениях и удалениях слоты удалённых документов освобождаются
+void TestRemovalChurnReclaimsOrdinals() {
+    mt19937 generator(5);
+    SearchServer server(""s);
+    map<int, pair<string, int>> live;
+    int next_id = 0;
+    for (int round = 0; round < 50; ++round) {
+        for (int i = 0; i < 40; ++i) {
+            const string text = MakeText(generator);
+            server.AddDocument(next_id, text, DocumentStatus::ACTUAL, { next_id % 7 });
+            live[next_id] = { text, next_id % 7 };
+            ++next_id;
+        }
+        vector<int> removed;
+        for (auto it = live.begin(); it != live.end() && removed.size() < 35; ++it) {
+            if (it->first % 3 != round % 3) {
+                removed.push_back(it->first);
+            }
+        }
+        for (size_t i = 0; i < removed.size(); ++i) {
+            if (i % 2 == 0) {
+                server.RemoveDocument(removed[i]);
+            }
+            else {
+                server.RemoveDocument(execution::par, removed[i]);
+            }
+            live.erase(removed[i]);
+        }
+        ASSERT_HINT(CountDocumentSlots(server) <= 2 * live.size() + 40, to_string(CountDocumentSlots(server)));
+    }
+    AssertSameResults(Rebuild(live), server);
+
+    server.CompactIndex();
+    ASSERT_EQUAL(CountDocumentSlots(server), live.size());
+    AssertSameResults(Rebuild(live), server);
+}
+
+// Документы отображённого индекса после переназначения номеров читаются по-прежнему
+void TestRenumberingMappedIndex() {
+    mt19937 generator(9);
+    SearchServer original(""s);
+    map<int, pair<string, int>> live;
+    for (int id = 0; id < 300; ++id) {
+        const string text = MakeText(generator);
+        original.AddDocument(id, text, DocumentStatus::ACTUAL, { id % 5 });
+        live[id] = { text, id % 5 };
+    }
+    TemporaryFile file("search_server_renumber.idx"s);
+    original.SaveIndex(file.GetPath());
+
+    SearchServer server = SearchServer::OpenIndex(file.GetPath());
+    server.AddDocument(1000, "w1 w2 w3"s, DocumentStatus::ACTUAL, { 1 });
+    live[1000] = { "w1 w2 w3"s, 1 };
+    vector<int> removed;
+    for (int id = 100; id < 280; ++id) {
+        removed.push_back(id);
+        live.erase(id);
+    }
+    server.RemoveDocuments(removed);
+    ASSERT(CountDocumentSlots(server) < 301);
+    AssertSameResults(Rebuild(live), server);
+}
+
+} // namespace
+
+void TestRemoval() {
+    RUN_TEST(TestRemovalChurnReclaimsOrdinals);
+    RUN_TEST(TestRenumberingMappedIndex);
+}
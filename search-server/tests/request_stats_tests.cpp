@@ -0,0 +1,67 @@
+#include "request_stats.h"
+#include "test_framework.h"
+#include "tests.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono_literals;
+
+namespace {
+
+void TestRequestStatsWindowExpires() {
+    RequestStats stats(1s, 10);
+    const auto start = RequestStats::Clock::now() + 1s;
+    stats.Record(start, true, 10ns);
+    stats.Record(start + 3s, false, 30ns);
+    auto window = stats.GetWindowStats(start + 5s);
+    ASSERT_EQUAL(window.request_count, 2u);
+    ASSERT_EQUAL(window.no_result_count, 1u);
+    ASSERT_EQUAL(window.latency_sum_ns, 40u);
+
+    window = stats.GetWindowStats(start + 12s);
+    ASSERT_EQUAL(window.request_count, 1u);
+    ASSERT_EQUAL(window.latency_sum_ns, 30u);
+
+    window = stats.GetWindowStats(start + 100s);
+    ASSERT_EQUAL(window.request_count, 0u);
+    ASSERT_EQUAL(stats.GetTotalStats().request_count, 2u);
+}
+
+// Потоки берут запросы из общего счётчика, так что пишут одновременно в одну и ту
+// же корзину и вместе переходят границы корзин. Окно длиннее всего потока
+// запросов, поэтому каждый запрос должен остаться в окне: сдвиг окна на новую
+// корзину не вправе забрать запрос, уже записанный в неё
+void TestRequestStatsConcurrentRolloverKeepsRequests() {
+    constexpr int THREAD_COUNT = 8;
+    constexpr uint64_t REQUEST_COUNT = 400000;
+    constexpr uint64_t REQUESTS_PER_BUCKET = 4;
+    RequestStats stats(1ms, REQUEST_COUNT / REQUESTS_PER_BUCKET + 10);
+    const auto start = RequestStats::Clock::now() + 1s;
+
+    atomic<uint64_t> next_request = 0;
+    vector<thread> threads;
+    for (int t = 0; t < THREAD_COUNT; ++t) {
+        threads.emplace_back([&stats, &next_request, start] {
+            for (uint64_t i = next_request++; i < REQUEST_COUNT; i = next_request++) {
+                stats.Record(start + 1ms * (i / REQUESTS_PER_BUCKET), true, 1ns);
+            }
+        });
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
+    const auto window = stats.GetWindowStats(start + 1ms * (REQUEST_COUNT / REQUESTS_PER_BUCKET));
+    ASSERT_EQUAL(window.request_count, REQUEST_COUNT);
+    ASSERT_EQUAL(window.latency_sum_ns, REQUEST_COUNT);
+}
+
+} // namespace
+
+void TestRequestStats() {
+    RUN_TEST(TestRequestStatsWindowExpires);
+    RUN_TEST(TestRequestStatsConcurrentRolloverKeepsRequests);
+}
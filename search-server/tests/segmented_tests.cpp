@@ -0,0 +1,104 @@
+#include "search_server.h"
+#include "segmented_search_server.h"
+#include "test_framework.h"
+#include "test_utils.h"
+#include "tests.h"
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const vector<string> TEXTS = {
+    "white cat fashionable collar"s,
+    "fluffy cat fluffy tail"s,
+    "groomed dog expressive eyes"s,
+    "groomed starling eugene"s,
+    "white dog long tail"s,
+    "black cat short tail"s,
+    "fluffy dog white collar"s,
+    "cat and dog"s,
+    "starling in white collar"s,
+    "tail of the dog"s,
+};
+
+// Удаления из запечатанных сегментов вычитаются из статистики слов: IDF и выдача
+// те же, что у одного сервера с теми же документами
+void TestSegmentedDeletionsMatchSingleIndex() {
+    SegmentPolicy policy;
+    policy.max_mutable_documents = 3;
+    policy.max_segment_count = 100;
+    SegmentedSearchServer segmented("and in of the"s, policy);
+    SearchServer single("and in of the"s);
+    for (int id = 0; id < static_cast<int>(TEXTS.size()); ++id) {
+        segmented.AddDocument(id, TEXTS[id], DocumentStatus::ACTUAL, { id });
+        single.AddDocument(id, TEXTS[id], DocumentStatus::ACTUAL, { id });
+    }
+    segmented.Flush();
+    ASSERT(segmented.GetSegmentCount() > 1);
+
+    for (const int id : { 1, 4, 7 }) {
+        segmented.RemoveDocument(id);
+        single.RemoveDocument(id);
+    }
+    ASSERT_EQUAL(segmented.GetDocumentCount(), single.GetDocumentCount());
+    for (const string& word : { "cat"s, "dog"s, "tail"s, "white"s, "fluffy"s, "collar"s }) {
+        ASSERT_EQUAL_HINT(segmented.GetTermDocumentCount(word), single.GetTermDocumentCount(word), word);
+    }
+    for (const string& query : { "cat"s, "fluffy tail"s, "white dog -collar"s, "starling eugene groomed"s }) {
+        AssertSameDocuments(single.FindTopDocuments(query), segmented.FindTopDocuments(query), query);
+    }
+}
+
+size_t CountFiles(const filesystem::path& directory) {
+    return distance(filesystem::directory_iterator(directory), filesystem::directory_iterator());
+}
+
+// Серверы с общим каталогом сегментов не трогают чужие файлы: ни файлы другого
+// живого сервера, ни оставшиеся от прошлого запуска
+void TestSegmentedServersShareDirectory() {
+    const filesystem::path directory = filesystem::temp_directory_path() / "search_server_segments"s;
+    filesystem::remove_all(directory);
+    filesystem::create_directories(directory);
+    const string stale_path = (directory / "segment_0.idx"s).string();
+    WriteBytes(stale_path, { 's', 't', 'a', 'l', 'e' });
+
+    SegmentPolicy policy;
+    policy.max_mutable_documents = 2;
+    policy.max_segment_count = 2;
+    policy.merge_factor = 2;
+    policy.directory = directory.string();
+    SearchServer single("and in of the"s);
+    auto first = make_unique<SegmentedSearchServer>("and in of the"s, policy);
+    SegmentedSearchServer second("and in of the"s, policy);
+    for (int id = 0; id < static_cast<int>(TEXTS.size()); ++id) {
+        single.AddDocument(id, TEXTS[id], DocumentStatus::ACTUAL, { id });
+        first->AddDocument(id, TEXTS[id], DocumentStatus::ACTUAL, { id });
+        second.AddDocument(id, TEXTS[id], DocumentStatus::ACTUAL, { id });
+    }
+    for (SegmentedSearchServer* server : { first.get(), &second }) {
+        server->Flush();
+        server->WaitForMerges();
+    }
+    ASSERT(CountFiles(directory) > 1);
+
+    // Первый сервер удаляет только свои файлы
+    first.reset();
+    ASSERT(CountFiles(directory) > 1);
+    for (const string& query : { "cat"s, "fluffy tail"s, "white dog -collar"s, "starling eugene groomed"s }) {
+        AssertSameDocuments(single.FindTopDocuments(query), second.FindTopDocuments(query), query);
+    }
+    ASSERT(ReadBytes(stale_path) == vector<char>({ 's', 't', 'a', 'l', 'e' }));
+    filesystem::remove_all(directory);
+}
+
+} // namespace
+
+void TestSegmentedSearchServer() {
+    RUN_TEST(TestSegmentedDeletionsMatchSingleIndex);
+    RUN_TEST(TestSegmentedServersShareDirectory);
+}
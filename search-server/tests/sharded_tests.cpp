@@ -0,0 +1,119 @@
+#include "search_server.h"
+#include "sharded_search_server.h"
+#include "test_framework.h"
+#include "test_utils.h"
+#include "tests.h"
+
+#include <execution>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const vector<string> QUERIES = { "w1"s, "w2 w3"s, "w4 -w5"s, "w0 w6 w7 w8"s, "w9 w10 w11 w12 w13"s, "w40"s };
+
+vector<string> MakeTexts(int count, mt19937& generator) {
+    uniform_int_distribution<int> word(0, 40);
+    uniform_int_distribution<int> length(1, 8);
+    vector<string> texts;
+    for (int i = 0; i < count; ++i) {
+        string text = "w"s + to_string(word(generator));
+        for (int j = length(generator); j > 1; --j) {
+            text += " w"s + to_string(word(generator));
+        }
+        texts.push_back(move(text));
+    }
+    return texts;
+}
+
+// Документы с id от first_id; тексты должны пережить пачку
+vector<NewDocument> MakeDocuments(int first_id, const vector<string>& texts) {
+    vector<NewDocument> documents;
+    for (size_t i = 0; i < texts.size(); ++i) {
+        const int id = first_id + static_cast<int>(i);
+        const DocumentStatus status = id % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        documents.push_back({ id, texts[i], status, { id % 7, -(id % 3) } });
+    }
+    return documents;
+}
+
+void AssertSameResults(const SearchServer& expected, const ShardedSearchServer& actual) {
+    ASSERT_EQUAL(expected.GetDocumentCount(), actual.GetDocumentCount());
+    for (const string& query : QUERIES) {
+        AssertSameDocuments(expected.FindTopDocuments(query), actual.FindTopDocuments(query), query);
+        AssertSameDocuments(expected.FindTopDocuments(query), actual.FindTopDocuments(execution::par, query), query);
+        AssertSameDocuments(expected.FindTopDocuments(query, DocumentStatus::BANNED, 50),
+            actual.FindTopDocuments(query, DocumentStatus::BANNED, 50), query);
+        const auto even = [](int document_id, DocumentStatus, int) { return document_id % 2 == 0; };
+        AssertSameDocuments(expected.FindTopDocuments(query, even), actual.FindTopDocuments(query, even), query);
+    }
+}
+
+// Шардированный индекс выдаёт то же, что один сервер с теми же документами,
+// в том числе после удалений и после пачки, откатившейся из-за ошибки
+void CheckShardedMatchesSingleIndex(const ShardingOptions& options) {
+    mt19937 generator(11);
+    SearchServer single(""s);
+    ShardedSearchServer sharded(""s, options);
+    const vector<string> texts = MakeTexts(300, generator);
+    const vector<NewDocument> corpus = MakeDocuments(0, texts);
+    single.AddDocuments(corpus);
+    sharded.AddDocuments(corpus);
+    AssertSameResults(single, sharded);
+
+    single.RemoveDocument(7);
+    sharded.RemoveDocument(7);
+    vector<int> removed;
+    for (int id = 20; id < 200; id += 3) {
+        removed.push_back(id);
+    }
+    single.RemoveDocuments(removed);
+    sharded.RemoveDocuments(execution::par, removed);
+    AssertSameResults(single, sharded);
+
+    // Последний документ пачки повторяет живой id: шард его отвергает, а документы,
+    // уже добавленные в другие шарды, удаляются
+    const vector<string> batch_texts = MakeTexts(30, generator);
+    vector<NewDocument> batch = MakeDocuments(1000, batch_texts);
+    batch.push_back(corpus.back());
+    bool is_rejected = false;
+    try {
+        sharded.AddDocuments(batch);
+    }
+    catch (const invalid_argument&) {
+        is_rejected = true;
+    }
+    ASSERT(is_rejected);
+    AssertSameResults(single, sharded);
+
+    batch.pop_back();
+    single.AddDocuments(batch);
+    sharded.AddDocuments(batch);
+    AssertSameResults(single, sharded);
+}
+
+void TestShardedMatchesSingleIndexByHash() {
+    for (const size_t shard_count : { 3, 5 }) {
+        ShardingOptions options;
+        options.shard_count = shard_count;
+        CheckShardedMatchesSingleIndex(options);
+    }
+}
+
+void TestShardedMatchesSingleIndexByRange() {
+    ShardingOptions options;
+    options.shard_count = 3;
+    options.range_bounds = { 100, 250 };
+    CheckShardedMatchesSingleIndex(options);
+}
+
+} // namespace
+
+void TestShardedSearchServer() {
+    RUN_TEST(TestShardedMatchesSingleIndexByHash);
+    RUN_TEST(TestShardedMatchesSingleIndexByRange);
+}
@@ -0,0 +1,53 @@
+#include "test_utils.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#include "test_framework.h"
+
+using namespace std;
+
+string DescribeIds(const vector<Document>& documents) {
+    ostringstream out;
+    for (const Document& document : documents) {
+        out << document.id << ' ';
+    }
+    return out.str();
+}
+
+void AssertSameDocuments(const vector<Document>& expected, const vector<Document>& actual, const string& query) {
+    const string hint = "query \""s + query + "\": "s + DescribeIds(expected) + "vs "s + DescribeIds(actual);
+    ASSERT_EQUAL_HINT(expected.size(), actual.size(), hint);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQUAL_HINT(expected[i].id, actual[i].id, hint);
+        ASSERT_EQUAL_HINT(expected[i].rating, actual[i].rating, hint);
+        ASSERT_EQUAL_HINT(expected[i].relevance, actual[i].relevance, hint);
+    }
+}
+
+TemporaryFile::TemporaryFile(const string& name)
+    : path_((filesystem::temp_directory_path() / name).string()) {
+}
+
+TemporaryFile::~TemporaryFile() {
+    error_code error;
+    filesystem::remove(path_, error);
+}
+
+vector<char> ReadBytes(const string& path) {
+    ifstream in(path, ios::binary);
+    return vector<char>(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+void WriteBytes(const string& path, const vector<char>& bytes) {
+    ofstream out(path, ios::binary | ios::trunc);
+    out.write(bytes.data(), static_cast<streamsize>(bytes.size()));
+}
+
+vector<char> SaveIndexBytes(const SearchServer& server, const string& name) {
+    TemporaryFile file(name);
+    server.SaveIndex(file.GetPath());
+    return ReadBytes(file.GetPath());
+}
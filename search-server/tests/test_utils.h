@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "document.h"
+#include "search_server.h"
+
+// id документов через пробел, для подсказок в проверках
+std::string DescribeIds(const std::vector<Document>& documents);
+
+// Выдачи совпадают по id, рейтингу и релевантности, включая порядок
+void AssertSameDocuments(const std::vector<Document>& expected, const std::vector<Document>& actual, const std::string& query);
+
+// Файл во временном каталоге, удаляется вместе с объектом
+class TemporaryFile {
+public:
+    explicit TemporaryFile(const std::string& name);
+    ~TemporaryFile();
+
+    TemporaryFile(const TemporaryFile&) = delete;
+    TemporaryFile& operator=(const TemporaryFile&) = delete;
+
+    const std::string& GetPath() const {
+        return path_;
+    }
+
+private:
+    std::string path_;
+};
+
+std::vector<char> ReadBytes(const std::string& path);
+void WriteBytes(const std::string& path, const std::vector<char>& bytes);
+
+// Содержимое файла индекса сервера: одинаковые индексы дают одинаковые байты
+std::vector<char> SaveIndexBytes(const SearchServer& server, const std::string& name);
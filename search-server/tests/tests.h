@@ -0,0 +1,13 @@
+#pragma once
+
+// Точки входа групп тестов, каждая запускает свои тесты через RUN_TEST
+void TestRanking();
+void TestSegmentedSearchServer();
+void TestRequestStats();
+void TestIndexFile();
+void TestBulkIngestion();
+void TestQuerySyntax();
+void TestRemoval();
+void TestConcurrentSearchServer();
+void TestShardedSearchServer();
+void TestPagination();